@@ -0,0 +1,60 @@
+#include "Benchmark.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <vector>
+
+static bool HasFailedCheck = false;
+
+void Benchmark::Report(const char* aName, const Timing& aTiming, std::size_t anItemCount)
+{
+	const double bestMicroseconds = static_cast<double>(aTiming.Best.count()) / 1000.0;
+	const double medianMicroseconds = static_cast<double>(aTiming.Median.count()) / 1000.0;
+
+	if (anItemCount == 0)
+	{
+		std::printf("  %-48s best %10.1f us  median %10.1f us\n", aName, bestMicroseconds, medianMicroseconds);
+		return;
+	}
+
+	const double nanosecondsPerItem = static_cast<double>(aTiming.Median.count()) / static_cast<double>(anItemCount);
+	std::printf("  %-48s best %10.1f us  median %10.1f us  %8.2f ns/item (%zu items)\n", aName, bestMicroseconds, medianMicroseconds, nanosecondsPerItem, anItemCount);
+}
+
+void Benchmark::Check(const char* aName, bool aPassed)
+{
+	std::printf("  %-48s %s\n", aName, aPassed ? "ok" : "FAILED");
+	if (!aPassed)
+		HasFailedCheck = true;
+}
+
+void Benchmark::Consume(std::uint64_t aValue)
+{
+	static std::atomic<std::uint64_t> sink = 0;
+	sink.fetch_xor(aValue, std::memory_order_relaxed);
+}
+
+int main(int anArgumentCount, const char** someArguments)
+{
+	std::vector<std::filesystem::path> midiFiles;
+	for (int i = 1; i < anArgumentCount; ++i)
+		midiFiles.emplace_back(someArguments[i]);
+
+	try
+	{
+		Benchmark::RunMidiBenchmarks(midiFiles);
+		Benchmark::RunTempoMapBenchmarks();
+		Benchmark::RunMarkerBenchmarks();
+		Benchmark::RunControllerBenchmarks();
+		Benchmark::RunScriptedInputChecks();
+		Benchmark::RunReplayChecks();
+	}
+	catch (const std::exception& anException)
+	{
+		std::printf("Benchmark stopped: %s\n", anException.what());
+		return 1;
+	}
+
+	return HasFailedCheck ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+// Headless measurements of the chart code, run from the benchmark executable.
+// Every benchmark runs on synthetic charts of known sizes, and on any MIDI files passed on the command line.
+namespace Benchmark
+{
+	struct Timing
+	{
+		std::chrono::nanoseconds Best = std::chrono::nanoseconds::max();
+		std::chrono::nanoseconds Median = std::chrono::nanoseconds(0);
+	};
+
+	// Runs aFunction aRunCount times, after one untimed run to warm up caches.
+	template <typename Function>
+	Timing Measure(std::size_t aRunCount, Function aFunction);
+
+	// Prints a timing, along with the time per item when there's a count to divide by.
+	void Report(const char* aName, const Timing& aTiming, std::size_t anItemCount = 0);
+
+	// Prints a check, and makes the benchmark executable fail if it didn't pass.
+	void Check(const char* aName, bool aPassed);
+
+	// Keeps the optimizer from throwing away work whose result isn't otherwise used.
+	void Consume(std::uint64_t aValue);
+
+	void RunMidiBenchmarks(std::span<const std::filesystem::path> someMidiFiles);
+	void RunTempoMapBenchmarks();
+	void RunMarkerBenchmarks();
+	void RunControllerBenchmarks();
+
+	// Feeds controllers timestamped input scripts and checks they're judged the same at any frame rate.
+	void RunScriptedInputChecks();
+
+	// Records a session that changes settings partway through, saves and loads it as a replay, and checks it plays back the same.
+	void RunReplayChecks();
+}
+
+template <typename Function>
+inline Benchmark::Timing Benchmark::Measure(std::size_t aRunCount, Function aFunction)
+{
+	aFunction();
+
+	std::vector<std::chrono::nanoseconds> runs;
+	runs.reserve(aRunCount);
+	for (std::size_t i = 0; i < aRunCount; ++i)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		aFunction();
+		runs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+	}
+
+	Timing timing;
+	if (runs.empty())
+		return timing;
+
+	std::sort(runs.begin(), runs.end());
+	timing.Best = runs.front();
+	timing.Median = runs[runs.size() / 2];
+	return timing;
+}
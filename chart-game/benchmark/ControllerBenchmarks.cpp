@@ -0,0 +1,253 @@
+#include "Benchmark.hpp"
+#include "SyntheticMidi.hpp"
+
+#include "ChartCalibration.hpp"
+#include "ChartController.hpp"
+#include "ChartData.hpp"
+#include "ChartReplay.hpp"
+#include "ChartTrack.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <vector>
+
+namespace
+{
+	class BenchmarkController : public ChartController
+	{
+	public:
+		const char* GetName() const override { return "Benchmark"; }
+	};
+
+	class ScriptedDeviceController : public BenchmarkController
+	{
+	public:
+		const char* GetInputDevice() const override { return "Scripted"; }
+	};
+
+	// Holds the lanes of every chord shortly before it and strums aStrumOffset after it starts.
+	std::vector<ChartController::TimedInput> MakeChordScript(std::span<const ChartChord> someChords, std::chrono::microseconds aStrumOffset = std::chrono::microseconds(0))
+	{
+		using TimedInput = ChartController::TimedInput;
+
+		std::vector<TimedInput> inputs;
+		std::uint8_t heldLanes = 0;
+		for (const ChartChord& chord : someChords)
+		{
+			const std::chrono::microseconds gripTime = chord.Start - std::chrono::microseconds(5'000);
+			for (std::uint8_t lane = 0; lane < 5; ++lane)
+			{
+				const bool isWanted = (chord.Lanes & (1 << lane)) != 0;
+				const bool isHeld = (heldLanes & (1 << lane)) != 0;
+				if (isHeld && !isWanted)
+					inputs.push_back({ gripTime, TimedInput::Action::ReleaseLane, lane });
+				else if (!isHeld && isWanted)
+					inputs.push_back({ gripTime, TimedInput::Action::PressLane, lane });
+			}
+
+			heldLanes = chord.Lanes;
+			inputs.push_back({ chord.Start + aStrumOffset, TimedInput::Action::Strum, 0 });
+		}
+
+		return inputs;
+	}
+
+	// Steps through the whole chart a frame at a time, queueing each input in the frame it happens in.
+	// Returns the number of frames.
+	std::size_t PlayChart(ChartController& aController, std::span<const ChartController::TimedInput> someInputs, std::chrono::microseconds anEnd, std::chrono::microseconds aFrameTime = std::chrono::microseconds(16'667))
+	{
+		std::size_t nextInput = 0;
+		std::size_t frameCount = 0;
+		for (std::chrono::microseconds playhead(0); playhead < anEnd; playhead += aFrameTime)
+		{
+			while (nextInput < someInputs.size() && someInputs[nextInput].Time <= playhead + aFrameTime)
+				aController.QueueInput(someInputs[nextInput++]);
+
+			aController.HandlePlayheadStep(playhead, playhead + aFrameTime);
+			++frameCount;
+		}
+
+		return frameCount;
+	}
+
+	struct PlayResult
+	{
+		unsigned int HitCount = 0;
+		unsigned int MaximumStreak = 0;
+		unsigned int Score = 0;
+
+		bool operator==(const PlayResult& anOther) const = default;
+	};
+}
+
+void Benchmark::RunScriptedInputChecks()
+{
+	std::printf("== Scripted input\n");
+
+	ChartData chart;
+	chart.LoadMidi(SyntheticMidi::MakeGuitarChart(1'000).Save("synthetic-1000"));
+
+	const std::span<const ChartChord> chords = chart.GetTracks().at(ChartTrackType::LeadGuitar)->GetChords(ChartTrackDifficulty::Expert);
+	const std::chrono::microseconds end = chords.back().Start + std::chrono::seconds(1);
+
+	// Strums land off the frame boundaries, so judging them at the end of their frame could change what they hit.
+	const std::vector<ChartController::TimedInput> inputs = MakeChordScript(chords, std::chrono::microseconds(7'123));
+
+	const auto play = [](const ChartData& aChart, std::span<const ChartController::TimedInput> someInputs, std::chrono::microseconds anEnd, std::chrono::microseconds aFrameTime)
+		{
+			BenchmarkController controller;
+			controller.SetTrackDifficulty(ChartTrackDifficulty::Expert);
+			controller.HandleChartChange(aChart);
+			PlayChart(controller, someInputs, anEnd, aFrameTime);
+
+			const ChartScoring& scoring = controller.GetScoring();
+			return PlayResult { scoring.GetHitCount(), scoring.GetMaximumStreak(), scoring.GetScore() };
+		};
+
+	const PlayResult expected = play(chart, inputs, end, std::chrono::microseconds(1'000));
+	std::printf("  %u notes hit, longest streak %u, score %u\n", expected.HitCount, expected.MaximumStreak, expected.Score);
+
+	const std::chrono::microseconds frameTimes[] = { std::chrono::microseconds(4'167), std::chrono::microseconds(16'667), std::chrono::microseconds(33'333), std::chrono::microseconds(250'000), std::chrono::microseconds(1'000'000) };
+
+	bool isFrameRateIndependent = expected.HitCount > 0;
+	for (const std::chrono::microseconds frameTime : frameTimes)
+		isFrameRateIndependent = isFrameRateIndependent && play(chart, inputs, end, frameTime) == expected;
+
+	Check("judgements don't depend on the frame rate", isFrameRateIndependent);
+
+	// Single notes two seconds apart, strummed alternately just inside and just outside the hit window, early then late.
+	// Judging a strum at any time but its own would move it across the edge of the window.
+	SyntheticMidi edgeMidi;
+	edgeMidi.AddTrack("chart");
+	edgeMidi.AddTempo(0, 500'000);
+	edgeMidi.AddTrack("PART GUITAR");
+
+	constexpr std::size_t EdgeNoteCount = 40;
+	const std::uint32_t noteSpacing = edgeMidi.GetTicksPerQuarterNote() * 4;
+	for (std::size_t i = 1; i <= EdgeNoteCount; ++i)
+		edgeMidi.AddNote(static_cast<std::uint32_t>(i) * noteSpacing, edgeMidi.GetTicksPerQuarterNote() / 4, 96);
+
+	ChartData edgeChart;
+	edgeChart.LoadMidi(edgeMidi.Save("hit-window-edges"));
+
+	const std::span<const ChartChord> edgeChords = edgeChart.GetTracks().at(ChartTrackType::LeadGuitar)->GetChords(ChartTrackDifficulty::Expert);
+	const std::chrono::microseconds hitWindow = ChartCalibration().GetHitWindow();
+	const std::chrono::microseconds margin(1'000);
+
+	std::vector<ChartController::TimedInput> edgeInputs;
+	edgeInputs.push_back({ std::chrono::microseconds(0), ChartController::TimedInput::Action::PressLane, 0 });
+	for (std::size_t i = 0; i < edgeChords.size(); ++i)
+	{
+		const bool isInside = (i % 2 == 0);
+		const bool isEarly = (i % 4 < 2);
+		const std::chrono::microseconds offset = isInside ? hitWindow - margin : hitWindow + margin;
+		edgeInputs.push_back({ edgeChords[i].Start + (isEarly ? -offset : offset), ChartController::TimedInput::Action::Strum, 0 });
+	}
+
+	const std::chrono::microseconds edgeEnd = edgeChords.back().Start + std::chrono::seconds(1);
+	bool isJudgedAtStrumTime = edgeChords.size() == EdgeNoteCount;
+	for (const std::chrono::microseconds frameTime : frameTimes)
+		isJudgedAtStrumTime = isJudgedAtStrumTime && play(edgeChart, edgeInputs, edgeEnd, frameTime).HitCount == EdgeNoteCount / 2;
+
+	Check("strums are judged at the time they happened", isJudgedAtStrumTime);
+}
+
+void Benchmark::RunReplayChecks()
+{
+	std::printf("== Replays\n");
+
+	ChartData chart;
+	chart.LoadMidi(SyntheticMidi::MakeGuitarChart(1'000).Save("synthetic-1000"));
+
+	const std::span<const ChartChord> chords = chart.GetTracks().at(ChartTrackType::LeadGuitar)->GetChords(ChartTrackDifficulty::Expert);
+	const std::chrono::microseconds end = chords.back().Start + std::chrono::seconds(1);
+	const std::vector<ChartController::TimedInput> inputs = MakeChordScript(chords, std::chrono::microseconds(7'123));
+
+	ChartCalibration calibration;
+	calibration.SetInputOffset("Scripted", std::chrono::microseconds(12'000));
+
+	ScriptedDeviceController controller;
+	controller.SetCalibration(calibration);
+	controller.SetTrackDifficulty(ChartTrackDifficulty::Expert);
+	controller.HandleChartChange(chart);
+	controller.SetRecordingInputs(true);
+
+	// Settings change partway through, the way they do while a player tries things out. A replay only sees where they ended up.
+	const std::chrono::microseconds frameTime(16'667);
+	std::size_t nextInput = 0;
+	for (std::chrono::microseconds playhead(0); playhead < end; playhead += frameTime)
+	{
+		if (playhead < end / 4 && playhead + frameTime >= end / 4)
+			controller.SetTrackDifficulty(ChartTrackDifficulty::Hard);
+		else if (playhead < end / 2 && playhead + frameTime >= end / 2)
+			calibration.SetHitWindow(calibration.GetHitWindow() / 2);
+		else if (playhead < end * 3 / 4 && playhead + frameTime >= end * 3 / 4)
+		{
+			controller.SetTrackDifficulty(ChartTrackDifficulty::Expert);
+			calibration.SetInputOffset("Scripted", std::chrono::microseconds(20'000));
+		}
+
+		while (nextInput < inputs.size() && inputs[nextInput].Time <= playhead + frameTime)
+			controller.QueueInput(inputs[nextInput++]);
+
+		controller.HandlePlayheadStep(playhead, playhead + frameTime);
+	}
+
+	ChartReplay replay(chart);
+	replay.AddController(controller);
+
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "chart-benchmark-replay.bin";
+	ChartReplay loadedReplay;
+	const bool isRoundTripped = replay.Save(path) && loadedReplay.Load(path);
+	std::filesystem::remove(path);
+
+	std::printf("  %u notes hit since the last settings change\n", controller.GetScoring().GetHitCount());
+	Check("saved replays play back the same", isRoundTripped && controller.GetScoring().GetHitCount() > 0 && loadedReplay.Verify(chart));
+}
+
+void Benchmark::RunControllerBenchmarks()
+{
+	std::printf("== Controller updates\n");
+
+	constexpr std::size_t RunCount = 5;
+
+	for (const std::size_t noteCount : { 1'000, 10'000, 100'000 })
+	{
+		const std::string name = std::format("synthetic-{}", noteCount);
+		ChartData chart;
+		chart.LoadMidi(SyntheticMidi::MakeGuitarChart(noteCount).Save(name));
+
+		const ChartTrack& track = *chart.GetTracks().at(ChartTrackType::LeadGuitar);
+		const std::span<const ChartChord> chords = track.GetChords(ChartTrackDifficulty::Expert);
+		const std::vector<ChartController::TimedInput> inputs = MakeChordScript(chords);
+		const std::chrono::microseconds end = chords.back().Start + std::chrono::seconds(1);
+
+		std::printf("%s (%zu chords on expert)\n", name.c_str(), chords.size());
+
+		std::size_t frameCount = 0;
+		std::vector<unsigned int> scores;
+
+		const auto play = [&](std::span<const ChartController::TimedInput> someInputs)
+			{
+				BenchmarkController controller;
+				controller.SetTrackDifficulty(ChartTrackDifficulty::Expert);
+				controller.HandleChartChange(chart);
+
+				frameCount = PlayChart(controller, someInputs, end);
+				scores.push_back(controller.GetScoring().GetScore());
+			};
+
+		const Timing playedTiming = Measure(RunCount, [&]() { play(inputs); });
+		const bool isScoreRepeatable = std::all_of(scores.begin(), scores.end(), [&](unsigned int aScore) { return aScore == scores.front(); });
+		const bool isScored = scores.front() > 0;
+
+		const Timing idleTiming = Measure(RunCount, [&]() { play({ }); });
+
+		// Per frame, so charts of different lengths compare directly.
+		Report("frames with every chord played", playedTiming, frameCount);
+		Report("frames without any input", idleTiming, frameCount);
+		Check("every run gets the same score", isScoreRepeatable && isScored);
+	}
+}
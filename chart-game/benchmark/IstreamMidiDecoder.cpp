@@ -0,0 +1,332 @@
+#include "IstreamMidiDecoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template <typename T>
+static std::uint8_t ReadFixed(std::istream& aStream, T& anOut, unsigned int anOffset = 0)
+{
+	anOut = T();
+	aStream.read(reinterpret_cast<char*>(&anOut), sizeof(T) - anOffset);
+	if constexpr (sizeof(T) != 1)
+		std::reverse(reinterpret_cast<char*>(&anOut), reinterpret_cast<char*>(&anOut) + sizeof(T) - anOffset);
+	return static_cast<std::uint8_t>(sizeof(T) - anOffset);
+}
+
+[[nodiscard]]
+static std::uint8_t ReadVariable(std::istream& aStream, std::uint32_t& anOut)
+{
+	anOut = 0;
+	std::uint8_t readBytes = 0;
+
+	std::uint8_t c = 0;
+	do
+	{
+		readBytes += ReadFixed(aStream, c);
+		anOut = (anOut << 7) + (c & 0x7F);
+	} while ((c & 0x80) != 0 && readBytes < 4);
+
+	return readBytes;
+}
+
+static std::string ReadText(std::istream& aStream, std::uint32_t aLength)
+{
+	std::string text(aLength, '\0');
+	aStream.read(text.data(), aLength);
+	return text;
+}
+
+void IstreamMidiDecoder::ProcessFile(const std::filesystem::path& aPath, MidiDecoder::FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote)
+{
+	std::ifstream fileStream;
+	fileStream.open(aPath, std::ios::in | std::ios::binary);
+	if (!fileStream.is_open())
+		throw std::runtime_error("Couldn't open MIDI file.");
+
+	while (true)
+	{
+		char chunkMarker[4];
+		fileStream.read(chunkMarker, sizeof(chunkMarker));
+		if (fileStream.gcount() != sizeof(chunkMarker))
+			break;
+
+		if (std::memcmp(chunkMarker, "MThd", 4) == 0)
+		{
+			ReadHeaderChunk(fileStream, outFormatType, outTicksPerQuarterNote);
+		}
+		else if (std::memcmp(chunkMarker, "MTrk", 4) == 0)
+		{
+			ProcessTrackChunk(fileStream);
+		}
+		else
+		{
+			std::uint32_t chunkSize = 0;
+			ReadFixed(fileStream, chunkSize);
+			fileStream.seekg(chunkSize, std::ios::cur);
+		}
+	}
+}
+
+void IstreamMidiDecoder::ReadHeaderChunk(std::istream& aStream, MidiDecoder::FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote)
+{
+	std::uint32_t chunkSize = 0;
+	ReadFixed(aStream, chunkSize);
+
+	ReadFixed(aStream, outFormatType);
+
+	std::uint16_t trackCount = 0;
+	ReadFixed(aStream, trackCount);
+
+	std::uint16_t packedTimeCode = 0;
+	ReadFixed(aStream, packedTimeCode);
+	if ((packedTimeCode & 0x8000) != 0)
+		throw std::runtime_error("SMPTE conversion needs implementing.");
+
+	outTicksPerQuarterNote = (packedTimeCode & 0x7FFF);
+
+	// We read 6 fixed bytes, skip any remaining ones in this chunk.
+	aStream.seekg(chunkSize - 0x06, std::ios::cur);
+}
+
+void IstreamMidiDecoder::ProcessTrackChunk(std::istream& aStream)
+{
+	myTarget.OnNewTrack.Invoke();
+
+	std::uint32_t chunkSize = 0;
+	ReadFixed(aStream, chunkSize);
+
+	std::uint32_t readBytes = 0;
+	std::uint8_t runningStatus = 0;
+	std::uint32_t tickCount = 0;
+	while (readBytes < chunkSize)
+	{
+		if (!aStream.good())
+			throw std::runtime_error("Unexpected end of MIDI data.");
+
+		readBytes += ProcessEvent(aStream, tickCount, runningStatus);
+	}
+
+	aStream.seekg(chunkSize - readBytes, std::ios::cur);
+}
+
+std::uint32_t IstreamMidiDecoder::ProcessEvent(std::istream& aStream, std::uint32_t& aTickCount, std::uint8_t& aRunningEventStatus)
+{
+	std::uint32_t readBytes = 0;
+	std::uint32_t deltaTicks = 0;
+	readBytes += ReadVariable(aStream, deltaTicks);
+	aTickCount += deltaTicks;
+
+	if (aStream.peek() >= 0x80)
+		readBytes += ReadFixed(aStream, aRunningEventStatus);
+
+	return ProcessEventData(aStream, aTickCount, aRunningEventStatus) + readBytes;
+}
+
+std::uint32_t IstreamMidiDecoder::ProcessEventData(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t anEventStatus)
+{
+	constexpr std::uint8_t NoteOff = 0x80;
+	constexpr std::uint8_t NoteOn = 0x90;
+	constexpr std::uint8_t PolyKeyPressure = 0xA0;
+	constexpr std::uint8_t ControlChange = 0xB0;
+	constexpr std::uint8_t ProgramChange = 0xC0;
+	constexpr std::uint8_t ChannelPressure = 0xD0;
+	constexpr std::uint8_t PitchBend = 0xE0;
+
+	constexpr std::uint8_t SysEx_Standard = 0xF0;
+	constexpr std::uint8_t SysEx_NoEnd = 0xF7;
+	constexpr std::uint8_t Meta = 0xFF;
+
+	std::uint8_t type = 0;
+	std::uint8_t channelIndex = 0;
+	if (anEventStatus < SysEx_Standard)
+	{
+		type = (anEventStatus & 0xF0);
+		channelIndex = anEventStatus & 0x0F;
+	}
+	else
+	{
+		type = anEventStatus;
+		channelIndex = 0xFF;
+	}
+
+	std::uint8_t first = 0;
+	std::uint8_t second = 0;
+
+	switch (type)
+	{
+	case NoteOff:
+	case NoteOn:
+		return ReadNoteEvent(aStream, aTickCount, type == NoteOn, channelIndex);
+	case PolyKeyPressure:
+		ReadFixed(aStream, first);
+		ReadFixed(aStream, second);
+		myTarget.OnNotePressure.Invoke(aTickCount, channelIndex, first, second);
+		return 2;
+	case ControlChange:
+		return ReadControlChangeEvent(aStream, aTickCount, channelIndex);
+	case ProgramChange:
+		ReadFixed(aStream, first);
+		myTarget.OnProgramChange.Invoke(aTickCount, channelIndex, first);
+		return 1;
+	case ChannelPressure:
+		ReadFixed(aStream, first);
+		myTarget.OnChannelPressure.Invoke(aTickCount, channelIndex, first);
+		return 1;
+	case PitchBend:
+		ReadFixed(aStream, first);
+		ReadFixed(aStream, second);
+		return 2;
+	case SysEx_Standard:
+	case SysEx_NoEnd:
+		return ReadSysExEvent(aStream, aTickCount, type == SysEx_Standard);
+	case Meta:
+		return ReadMetaEvent(aStream, aTickCount);
+	}
+
+	throw std::runtime_error("Invalid event type.");
+}
+
+std::uint32_t IstreamMidiDecoder::ReadNoteEvent(std::istream& aStream, std::uint32_t aTickCount, bool anIsOn, std::uint8_t aChannelIndex)
+{
+	std::uint8_t noteNum = 0;
+	ReadFixed(aStream, noteNum);
+
+	std::uint8_t noteVelocity = 0;
+	ReadFixed(aStream, noteVelocity);
+
+	if (!anIsOn)
+		noteVelocity = 0;
+
+	myTarget.OnNote.Invoke(aTickCount, aChannelIndex, noteNum, noteVelocity);
+
+	return 2;
+}
+
+std::uint32_t IstreamMidiDecoder::ReadControlChangeEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex)
+{
+	std::uint8_t controllerNum = 0;
+	ReadFixed(aStream, controllerNum);
+
+	std::uint8_t controlValue = 0;
+	ReadFixed(aStream, controlValue);
+
+	switch (controllerNum)
+	{
+	case 120:
+		myTarget.OnSoundOff.Invoke(aTickCount, aChannelIndex);
+		break;
+	case 121:
+		myTarget.OnResetAllControllers.Invoke(aTickCount, aChannelIndex, controlValue);
+		break;
+	case 122:
+		myTarget.OnLocalControl.Invoke(aTickCount, aChannelIndex);
+		break;
+	case 123:
+		myTarget.OnAllNotesOff.Invoke(aTickCount, aChannelIndex);
+		break;
+	case 124:
+		myTarget.OnOmniOff.Invoke(aTickCount, aChannelIndex);
+		break;
+	case 125:
+		myTarget.OnOmniOn.Invoke(aTickCount, aChannelIndex);
+		break;
+	case 126:
+		myTarget.OnMonoOn.Invoke(aTickCount, aChannelIndex, controlValue);
+		break;
+	case 127:
+		myTarget.OnPolyOn.Invoke(aTickCount, aChannelIndex);
+		break;
+	default:
+		break;
+	}
+
+	return 2;
+}
+
+std::uint32_t IstreamMidiDecoder::ReadSysExEvent(std::istream& aStream, std::uint32_t aTickCount, bool aHasEnd)
+{
+	std::uint32_t readBytes = 0;
+
+	std::uint32_t length = 0;
+	readBytes += ReadVariable(aStream, length);
+
+	std::vector<std::uint8_t> data(length);
+	aStream.read(reinterpret_cast<char*>(data.data()), length);
+
+	myTarget.OnSysEx.Invoke(aTickCount, std::span<const std::uint8_t>(data.data(), (aHasEnd && length > 0) ? length - 1 : length));
+
+	return readBytes + length;
+}
+
+std::uint32_t IstreamMidiDecoder::ReadMetaEvent(std::istream& aStream, std::uint32_t aTickCount)
+{
+	std::uint32_t readBytes = 0;
+
+	std::uint8_t type = 0;
+	readBytes += ReadFixed(aStream, type);
+
+	std::uint32_t length = 0;
+	readBytes += ReadVariable(aStream, length);
+	readBytes += length;
+
+	// We have the length so we add it onto the read bytes, just read the data in the switch.
+	switch (MidiDecoder::MetaType(type))
+	{
+	case MidiDecoder::MetaType::Text:
+		myTarget.OnText.Invoke(aTickCount, ReadText(aStream, length));
+		return readBytes;
+	case MidiDecoder::MetaType::CopyrightNotice:
+		myTarget.OnCopyrightNotice.Invoke(aTickCount, ReadText(aStream, length));
+		return readBytes;
+	case MidiDecoder::MetaType::TrackName:
+		myTarget.OnTrackName.Invoke(aTickCount, ReadText(aStream, length));
+		return readBytes;
+	case MidiDecoder::MetaType::InstrumentName:
+		myTarget.OnInstrumentName.Invoke(aTickCount, ReadText(aStream, length));
+		return readBytes;
+	case MidiDecoder::MetaType::Lyric:
+		myTarget.OnLyric.Invoke(aTickCount, ReadText(aStream, length));
+		return readBytes;
+	case MidiDecoder::MetaType::Marker:
+		myTarget.OnMarker.Invoke(aTickCount, ReadText(aStream, length));
+		return readBytes;
+	case MidiDecoder::MetaType::CuePoint:
+		myTarget.OnCuePoint.Invoke(aTickCount, ReadText(aStream, length));
+		return readBytes;
+	case MidiDecoder::MetaType::EndOfTrack:
+		myTarget.OnTrackEnd.Invoke(aTickCount);
+		return readBytes;
+	case MidiDecoder::MetaType::SetTempo:
+	{
+		std::uint32_t tempo = 0;
+		ReadFixed(aStream, tempo, 1);
+		myTarget.OnSetTempo.Invoke(aTickCount, tempo);
+		return readBytes;
+	}
+	case MidiDecoder::MetaType::TimeSignature:
+	{
+		std::uint8_t num = 0;
+		std::uint8_t den = 0;
+		std::uint8_t clk = 0;
+		std::uint8_t base = 0;
+		ReadFixed(aStream, num);
+		ReadFixed(aStream, den);
+		den = 1 << den;
+		ReadFixed(aStream, clk);
+		ReadFixed(aStream, base);
+		myTarget.OnTimeSignature.Invoke(aTickCount, num, den, clk, base);
+		return readBytes;
+	}
+	default:
+		break;
+	}
+
+	// Event data not processed, skip over.
+	aStream.seekg(length, std::ios::cur);
+
+	return readBytes;
+}
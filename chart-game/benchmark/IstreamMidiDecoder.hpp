@@ -0,0 +1,32 @@
+#pragma once
+
+#include "MidiDecoder.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+
+// The stream based decoder that MidiDecoder replaced, kept as a reference to benchmark the in-memory decoder against.
+// Decoded events are passed on through the slots of another MidiDecoder, so both decoders do the same work per event.
+class IstreamMidiDecoder
+{
+public:
+	explicit IstreamMidiDecoder(MidiDecoder& aTarget) : myTarget(aTarget) { }
+
+	void ProcessFile(const std::filesystem::path& aPath, MidiDecoder::FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote);
+
+private:
+	void ReadHeaderChunk(std::istream& aStream, MidiDecoder::FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote);
+
+	void ProcessTrackChunk(std::istream& aStream);
+
+	std::uint32_t ProcessEvent(std::istream& aStream, std::uint32_t& aTickCount, std::uint8_t& aRunningEventStatus);
+	std::uint32_t ProcessEventData(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t anEventStatus);
+
+	std::uint32_t ReadNoteEvent(std::istream& aStream, std::uint32_t aTickCount, bool anIsOn, std::uint8_t aChannelIndex);
+	std::uint32_t ReadControlChangeEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex);
+	std::uint32_t ReadSysExEvent(std::istream& aStream, std::uint32_t aTickCount, bool aHasEnd);
+	std::uint32_t ReadMetaEvent(std::istream& aStream, std::uint32_t aTickCount);
+
+	MidiDecoder& myTarget;
+};
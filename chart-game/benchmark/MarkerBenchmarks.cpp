@@ -0,0 +1,127 @@
+#include "Benchmark.hpp"
+#include "SyntheticMidi.hpp"
+
+#include "ChartData.hpp"
+#include "ChartTrack.hpp"
+
+#include <array>
+#include <cstdio>
+#include <format>
+#include <string>
+
+namespace
+{
+	// Notes in the tap ranges, out of every TapCycle notes.
+	constexpr std::size_t TapCycle = 32;
+	constexpr std::size_t TapStart = 16;
+	constexpr std::size_t TapEnd = 24;
+
+	bool IsTapped(std::size_t aNoteIndex)
+	{
+		return aNoteIndex % TapCycle >= TapStart && aNoteIndex % TapCycle < TapEnd;
+	}
+
+	// The guitar chart with a force HOPO or force strum marker around every other note, on every difficulty,
+	// and a tap SysEx range over a quarter of the notes. Returns the number of markers and SysEx events added.
+	std::size_t AddMarkers(SyntheticMidi& aMidi, std::size_t aNoteCount)
+	{
+		// Matches the note layout of SyntheticMidi::MakeGuitarChart.
+		const std::uint32_t step = aMidi.GetTicksPerQuarterNote() / 4;
+		std::size_t markerCount = 0;
+
+		for (std::uint8_t difficulty = 0; difficulty < 4; ++difficulty)
+		{
+			const std::uint8_t firstNote = 60 + difficulty * 12;
+			for (std::size_t i = 1; i < aNoteCount; i += 2)
+			{
+				const std::uint32_t tick = static_cast<std::uint32_t>(i) * step;
+				const std::uint32_t length = (i % 16 == 0) ? step * 3 : step / 2;
+				aMidi.AddNote(tick, length, firstNote + (i % 4 == 1 ? 5 : 6));
+				++markerCount;
+			}
+		}
+
+		for (std::size_t i = TapStart; i < aNoteCount; i += TapCycle)
+		{
+			const std::array<std::uint8_t, 7> tapOn = { 'P', 'S', 0, 0, 0xFF, 0x04, 1 };
+			const std::array<std::uint8_t, 7> tapOff = { 'P', 'S', 0, 0, 0xFF, 0x04, 0 };
+			aMidi.AddSysEx(static_cast<std::uint32_t>(i) * step, tapOn);
+			aMidi.AddSysEx(static_cast<std::uint32_t>(i + TapEnd - TapStart) * step, tapOff);
+			markerCount += 2;
+		}
+
+		return markerCount;
+	}
+
+	// Checks the chords a load came out with against the markers that were put over them.
+	bool AreMarkersApplied(const ChartData& aChart, std::size_t aNoteCount)
+	{
+		const std::span<const ChartChord> chords = aChart.GetTracks().at(ChartTrackType::LeadGuitar)->GetChords(ChartTrackDifficulty::Expert);
+		if (chords.size() != aNoteCount)
+			return false;
+
+		for (std::size_t i = 0; i < chords.size(); ++i)
+		{
+			if (IsTapped(i))
+			{
+				if (chords[i].Type != ChartNoteType::Tap)
+					return false;
+			}
+			else if (i % 4 == 1 && chords[i].Type != ChartNoteType::HOPO)
+			{
+				return false;
+			}
+			else if (i % 4 == 3 && chords[i].Type != ChartNoteType::Strum)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+void Benchmark::RunMarkerBenchmarks()
+{
+	std::printf("== Chart loading with note markers\n");
+
+	constexpr std::size_t RunCount = 5;
+
+	for (const std::size_t noteCount : { 1'000, 10'000, 100'000 })
+	{
+		const std::string name = std::format("synthetic-{}", noteCount);
+		const std::filesystem::path plainPath = SyntheticMidi::MakeGuitarChart(noteCount).Save(name);
+
+		SyntheticMidi markedMidi = SyntheticMidi::MakeGuitarChart(noteCount);
+		const std::size_t markerCount = AddMarkers(markedMidi, noteCount);
+		const std::filesystem::path markedPath = markedMidi.Save(name + "-markers");
+
+		std::printf("%s (%zu markers)\n", name.c_str(), markerCount);
+
+		const Timing plainTiming = Measure(RunCount, [&]()
+			{
+				ChartData chart;
+				chart.LoadMidi(plainPath);
+			}
+		);
+
+		bool isApplied = true;
+		ChartData::LoadStatus status;
+		const Timing markedTiming = Measure(RunCount, [&]()
+			{
+				ChartData chart;
+				chart.LoadMidi(markedPath, ChartData::TrackFilter().set(), &status);
+				isApplied = isApplied && AreMarkersApplied(chart, noteCount);
+			}
+		);
+
+		Report("load without markers", plainTiming);
+		Report("load with markers", markedTiming);
+
+		// From the last load, after the arenas have had the earlier runs to grow into.
+		const ChartLoadArena::Statistics memory = status.GetMemory();
+		std::printf("  %-48s %zu, %zu from the heap, peaking at %zu KiB\n", "temporary allocations", memory.AllocationCount, memory.HeapAllocationCount, memory.PeakBytes / 1024);
+
+		Check("markers apply to the notes they cover", isApplied);
+	}
+}
@@ -0,0 +1,173 @@
+#include "Benchmark.hpp"
+#include "IstreamMidiDecoder.hpp"
+#include "SyntheticMidi.hpp"
+
+#include "MidiDecoder.hpp"
+
+#include <cstdio>
+#include <format>
+#include <iterator>
+#include <string>
+
+namespace
+{
+	// What a decoder passed on, to check that both decoders saw the same file.
+	struct DecodeSummary
+	{
+		std::size_t EventCount = 0;
+		std::uint64_t Checksum = 0;
+
+		bool operator==(const DecodeSummary& anOther) const = default;
+	};
+
+	class SummaryListener
+	{
+	public:
+		explicit SummaryListener(MidiDecoder& aDecoder)
+		{
+			aDecoder.OnNote.Connect(this, [this](std::uint32_t aTick, std::uint8_t aChannel, std::uint8_t aNote, std::uint8_t aVelocity)
+				{
+					Add(aTick, (aChannel << 16) | (aNote << 8) | aVelocity);
+				}
+			);
+			aDecoder.OnSetTempo.Connect(this, [this](std::uint32_t aTick, std::uint32_t aTempo) { Add(aTick, aTempo); });
+			aDecoder.OnText.Connect(this, [this](std::uint32_t aTick, std::string_view aText) { Add(aTick, aText.size()); });
+			aDecoder.OnTrackName.Connect(this, [this](std::uint32_t aTick, std::string_view aText) { Add(aTick, aText.size()); });
+			aDecoder.OnSysEx.Connect(this, [this](std::uint32_t aTick, const std::span<const std::uint8_t>& someData) { Add(aTick, someData.size()); });
+		}
+
+		const DecodeSummary& GetSummary() const { return mySummary; }
+		void Reset() { mySummary = { }; }
+
+	private:
+		void Add(std::uint32_t aTick, std::uint64_t aValue)
+		{
+			++mySummary.EventCount;
+			mySummary.Checksum = (mySummary.Checksum * 31) ^ (static_cast<std::uint64_t>(aTick) << 32) ^ aValue;
+		}
+
+		DecodeSummary mySummary;
+	};
+
+	void BenchmarkFile(const std::string& aName, const std::filesystem::path& aPath)
+	{
+		const std::vector<std::uint8_t> fileData = MidiDecoder::ReadFile(aPath);
+		std::printf("%s (%zu KiB)\n", aName.c_str(), fileData.size() / 1024);
+
+		constexpr std::size_t RunCount = 20;
+		MidiDecoder::FormatType formatType = MidiDecoder::FormatType::SingleTrack;
+		std::uint16_t ticksPerQuarterNote = 0;
+
+		MidiDecoder target;
+		SummaryListener listener(target);
+
+		IstreamMidiDecoder streamDecoder(target);
+		const Benchmark::Timing streamTiming = Benchmark::Measure(RunCount, [&]()
+			{
+				listener.Reset();
+				streamDecoder.ProcessFile(aPath, formatType, ticksPerQuarterNote);
+			}
+		);
+		const DecodeSummary streamSummary = listener.GetSummary();
+
+		const Benchmark::Timing fileTiming = Benchmark::Measure(RunCount, [&]()
+			{
+				listener.Reset();
+				target.ProcessFile(aPath, formatType, ticksPerQuarterNote);
+			}
+		);
+		const DecodeSummary fileSummary = listener.GetSummary();
+
+		const Benchmark::Timing dataTiming = Benchmark::Measure(RunCount, [&]()
+			{
+				listener.Reset();
+				target.ProcessData(fileData, formatType, ticksPerQuarterNote);
+			}
+		);
+
+		Benchmark::Report("istream decoder, from file", streamTiming, streamSummary.EventCount);
+		Benchmark::Report("span decoder, from file", fileTiming, fileSummary.EventCount);
+		Benchmark::Report("span decoder, already in memory", dataTiming, listener.GetSummary().EventCount);
+		Benchmark::Check("both decoders pass on the same events", streamSummary == fileSummary && fileSummary == listener.GetSummary());
+	}
+
+	void BenchmarkEventIteration(const std::string& aName, const std::filesystem::path& aPath)
+	{
+		const std::vector<std::uint8_t> fileData = MidiDecoder::ReadFile(aPath);
+		std::printf("%s\n", aName.c_str());
+
+		std::vector<std::span<const std::uint8_t>> trackChunks;
+		for (const MidiDecoder::Chunk& chunk : MidiDecoder::FindChunks(fileData))
+		{
+			if (chunk.Type == MidiDecoder::ChunkType::Track)
+				trackChunks.push_back(chunk.GetData(fileData));
+		}
+
+		std::size_t eventCount = 0;
+		for (std::span<const std::uint8_t> chunk : trackChunks)
+		{
+			const MidiDecoder::EventRange events = MidiDecoder::ReadTrackEvents(chunk);
+			eventCount += static_cast<std::size_t>(std::distance(events.begin(), events.end()));
+		}
+
+		// Both paths collect the same thing from every note, the way chart loading does.
+		constexpr std::size_t RunCount = 20;
+		std::uint64_t callbackSum = 0;
+		std::uint64_t iteratorSum = 0;
+
+		MidiDecoder decoder;
+		decoder.OnNote.Connect(&decoder, [&callbackSum](std::uint32_t aTick, std::uint8_t, std::uint8_t aNote, std::uint8_t aVelocity)
+			{
+				callbackSum += aTick + aNote + aVelocity;
+			}
+		);
+
+		const Benchmark::Timing callbackTiming = Benchmark::Measure(RunCount, [&]()
+			{
+				callbackSum = 0;
+				for (std::span<const std::uint8_t> chunk : trackChunks)
+					decoder.ProcessTrackChunk(chunk);
+			}
+		);
+
+		const Benchmark::Timing iteratorTiming = Benchmark::Measure(RunCount, [&]()
+			{
+				iteratorSum = 0;
+				for (std::span<const std::uint8_t> chunk : trackChunks)
+				{
+					for (const MidiDecoder::Event& event : MidiDecoder::ReadTrackEvents(chunk))
+					{
+						if (event.Type == MidiDecoder::EventType::Note)
+							iteratorSum += event.Tick + event.Data[0] + event.Data[1];
+					}
+				}
+			}
+		);
+
+		Benchmark::Report("event slots", callbackTiming, eventCount);
+		Benchmark::Report("event iterator", iteratorTiming, eventCount);
+		Benchmark::Check("both paths see the same notes", callbackSum == iteratorSum);
+		Benchmark::Consume(iteratorSum);
+	}
+}
+
+void Benchmark::RunMidiBenchmarks(std::span<const std::filesystem::path> someMidiFiles)
+{
+	std::vector<std::pair<std::string, std::filesystem::path>> files;
+	for (const std::size_t noteCount : { 1'000, 10'000, 100'000 })
+	{
+		const std::string name = std::format("synthetic-{}", noteCount);
+		files.emplace_back(name, SyntheticMidi::MakeGuitarChart(noteCount).Save(name));
+	}
+
+	for (const std::filesystem::path& path : someMidiFiles)
+		files.emplace_back(path.string(), path);
+
+	std::printf("== MIDI decoding\n");
+	for (const auto& [name, path] : files)
+		BenchmarkFile(name, path);
+
+	std::printf("== MIDI events per track, slots against iterator\n");
+	for (const auto& [name, path] : files)
+		BenchmarkEventIteration(name, path);
+}
@@ -0,0 +1,189 @@
+#include "SyntheticMidi.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+static void WriteVariable(std::vector<std::uint8_t>& someBytes, std::uint32_t aValue)
+{
+	std::uint8_t groups[5] = { };
+	std::size_t groupCount = 0;
+	do
+	{
+		groups[groupCount++] = static_cast<std::uint8_t>(aValue & 0x7F);
+		aValue >>= 7;
+	} while (aValue != 0);
+
+	while (groupCount > 1)
+		someBytes.push_back(groups[--groupCount] | 0x80);
+	someBytes.push_back(groups[0]);
+}
+
+static void WriteFixed(std::vector<std::uint8_t>& someBytes, std::uint32_t aValue, std::size_t aByteCount)
+{
+	// MIDI data is big-endian.
+	for (std::size_t i = aByteCount; i > 0; --i)
+		someBytes.push_back(static_cast<std::uint8_t>(aValue >> ((i - 1) * 8)));
+}
+
+SyntheticMidi::SyntheticMidi(std::uint16_t aTicksPerQuarterNote)
+	: myTicksPerQuarterNote(aTicksPerQuarterNote)
+{
+}
+
+void SyntheticMidi::AddTrack(std::string_view aName)
+{
+	myTracks.emplace_back();
+	AddMeta(0, 0x03, std::span(reinterpret_cast<const std::uint8_t*>(aName.data()), aName.size()));
+}
+
+void SyntheticMidi::AddTempo(std::uint32_t aTick, std::uint32_t aMicrosecondsPerBeat)
+{
+	std::vector<std::uint8_t> tempo;
+	WriteFixed(tempo, aMicrosecondsPerBeat, 3);
+	AddMeta(aTick, 0x51, tempo);
+}
+
+void SyntheticMidi::AddTimeSignature(std::uint32_t aTick, std::uint8_t aNumerator, std::uint8_t aDenominator)
+{
+	std::uint8_t denominatorPower = 0;
+	while ((1u << denominatorPower) < aDenominator)
+		++denominatorPower;
+
+	const std::uint8_t timeSignature[] = { aNumerator, denominatorPower, 24, 8 };
+	AddMeta(aTick, 0x58, timeSignature);
+}
+
+void SyntheticMidi::AddText(std::uint32_t aTick, std::string_view aText)
+{
+	AddMeta(aTick, 0x01, std::span(reinterpret_cast<const std::uint8_t*>(aText.data()), aText.size()));
+}
+
+void SyntheticMidi::AddNote(std::uint32_t aTick, std::uint32_t aLength, std::uint8_t aNote, std::uint8_t aVelocity)
+{
+	AddEvent(aTick, { 0x90, aNote, aVelocity });
+	AddEvent(aTick + aLength, { 0x80, aNote, 0 }, true);
+}
+
+void SyntheticMidi::AddSysEx(std::uint32_t aTick, std::span<const std::uint8_t> someData)
+{
+	std::vector<std::uint8_t> bytes = { 0xF0 };
+	WriteVariable(bytes, static_cast<std::uint32_t>(someData.size() + 1));
+	bytes.insert(bytes.end(), someData.begin(), someData.end());
+	bytes.push_back(0xF7);
+	AddEvent(aTick, std::move(bytes));
+}
+
+std::vector<std::uint8_t> SyntheticMidi::Build() const
+{
+	std::vector<std::uint8_t> data = { 'M', 'T', 'h', 'd' };
+	WriteFixed(data, 6, 4);
+	WriteFixed(data, 1, 2);
+	WriteFixed(data, static_cast<std::uint32_t>(myTracks.size()), 2);
+	WriteFixed(data, myTicksPerQuarterNote, 2);
+
+	std::vector<const TrackEvent*> events;
+	std::vector<std::uint8_t> trackData;
+	for (const std::vector<TrackEvent>& track : myTracks)
+	{
+		events.clear();
+		for (const TrackEvent& event : track)
+			events.push_back(&event);
+
+		std::stable_sort(events.begin(), events.end(), [](const TrackEvent* aLeft, const TrackEvent* aRight)
+			{
+				if (aLeft->Tick != aRight->Tick)
+					return aLeft->Tick < aRight->Tick;
+				return aLeft->IsNoteOff && !aRight->IsNoteOff;
+			}
+		);
+
+		trackData.clear();
+		std::uint32_t tick = 0;
+		for (const TrackEvent* event : events)
+		{
+			WriteVariable(trackData, event->Tick - tick);
+			trackData.insert(trackData.end(), event->Bytes.begin(), event->Bytes.end());
+			tick = event->Tick;
+		}
+
+		// End of track.
+		trackData.insert(trackData.end(), { 0x00, 0xFF, 0x2F, 0x00 });
+
+		data.insert(data.end(), { 'M', 'T', 'r', 'k' });
+		WriteFixed(data, static_cast<std::uint32_t>(trackData.size()), 4);
+		data.insert(data.end(), trackData.begin(), trackData.end());
+	}
+
+	return data;
+}
+
+std::filesystem::path SyntheticMidi::Save(std::string_view aName) const
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / std::format("chart-benchmark-{}.mid", aName);
+	const std::vector<std::uint8_t> data = Build();
+
+	std::ofstream fileStream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	fileStream.write(reinterpret_cast<const char*>(data.data()), data.size());
+	if (!fileStream.good())
+		throw std::runtime_error("Couldn't write synthetic MIDI file.");
+
+	return path;
+}
+
+SyntheticMidi SyntheticMidi::MakeGuitarChart(std::size_t aNoteCount, std::size_t aTempoInterval)
+{
+	SyntheticMidi midi;
+	const std::uint32_t step = midi.GetTicksPerQuarterNote() / 4;
+
+	midi.AddTrack("chart");
+	midi.AddTimeSignature(0, 4, 4);
+	for (std::size_t i = 0; i < aNoteCount; i += std::max<std::size_t>(aTempoInterval, 1))
+		midi.AddTempo(static_cast<std::uint32_t>(i) * step, 400'000 + static_cast<std::uint32_t>(i / aTempoInterval % 5) * 25'000);
+
+	midi.AddTrack("EVENTS");
+	for (std::size_t i = 0; i < aNoteCount; i += 64)
+		midi.AddText(static_cast<std::uint32_t>(i) * step, std::format("[section part_{}]", i / 64));
+
+	// Fixed seed, so every run benchmarks the same chart.
+	std::minstd_rand random(1);
+
+	midi.AddTrack("PART GUITAR");
+	for (std::uint8_t difficulty = 0; difficulty < 4; ++difficulty)
+	{
+		const std::uint8_t firstNote = 60 + difficulty * 12;
+		for (std::size_t i = 0; i < aNoteCount; ++i)
+		{
+			const std::uint32_t tick = static_cast<std::uint32_t>(i) * step;
+			const std::uint32_t length = (i % 16 == 0) ? step * 3 : step / 2;
+			const std::uint8_t lane = static_cast<std::uint8_t>(random() % 5);
+
+			midi.AddNote(tick, length, firstNote + lane);
+			if (i % 8 == 0)
+				midi.AddNote(tick, length, firstNote + (lane + 2) % 5);
+		}
+	}
+
+	return midi;
+}
+
+void SyntheticMidi::AddEvent(std::uint32_t aTick, std::vector<std::uint8_t> someBytes, bool anIsNoteOff)
+{
+	if (myTracks.empty())
+		throw std::logic_error("Events need a track to go in.");
+
+	TrackEvent& event = myTracks.back().emplace_back();
+	event.Tick = aTick;
+	event.IsNoteOff = anIsNoteOff;
+	event.Bytes = std::move(someBytes);
+}
+
+void SyntheticMidi::AddMeta(std::uint32_t aTick, std::uint8_t aType, std::span<const std::uint8_t> someData)
+{
+	std::vector<std::uint8_t> bytes = { 0xFF, aType };
+	WriteVariable(bytes, static_cast<std::uint32_t>(someData.size()));
+	bytes.insert(bytes.end(), someData.begin(), someData.end());
+	AddEvent(aTick, std::move(bytes));
+}
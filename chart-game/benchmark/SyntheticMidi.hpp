@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Builds format 1 MIDI files in memory, for benchmarking charts of a chosen size.
+// Events can be added to a track in any order; they're put in tick order when the file is built.
+class SyntheticMidi
+{
+public:
+	explicit SyntheticMidi(std::uint16_t aTicksPerQuarterNote = 480);
+
+	std::uint16_t GetTicksPerQuarterNote() const { return myTicksPerQuarterNote; }
+
+	// Starts a new track, which the events added after it go in.
+	void AddTrack(std::string_view aName);
+
+	void AddTempo(std::uint32_t aTick, std::uint32_t aMicrosecondsPerBeat);
+	void AddTimeSignature(std::uint32_t aTick, std::uint8_t aNumerator, std::uint8_t aDenominator);
+	void AddText(std::uint32_t aTick, std::string_view aText);
+	void AddNote(std::uint32_t aTick, std::uint32_t aLength, std::uint8_t aNote, std::uint8_t aVelocity = 100);
+	void AddSysEx(std::uint32_t aTick, std::span<const std::uint8_t> someData);
+
+	std::vector<std::uint8_t> Build() const;
+
+	// Builds the file and writes it to a temporary path, for code that loads charts from disk.
+	std::filesystem::path Save(std::string_view aName) const;
+
+	// A five lane guitar chart with aNoteCount notes per difficulty, a tempo change every aTempoInterval notes,
+	// and a section name every 64 notes.
+	static SyntheticMidi MakeGuitarChart(std::size_t aNoteCount, std::size_t aTempoInterval = 16);
+
+private:
+	struct TrackEvent
+	{
+		std::uint32_t Tick = 0;
+		// Note offs go before anything else on the same tick, so notes that end where another starts pair up correctly.
+		bool IsNoteOff = false;
+		std::vector<std::uint8_t> Bytes;
+	};
+
+	void AddEvent(std::uint32_t aTick, std::vector<std::uint8_t> someBytes, bool anIsNoteOff = false);
+	void AddMeta(std::uint32_t aTick, std::uint8_t aType, std::span<const std::uint8_t> someData);
+
+	std::uint16_t myTicksPerQuarterNote;
+	std::vector<std::vector<TrackEvent>> myTracks;
+};
@@ -0,0 +1,128 @@
+#include "Benchmark.hpp"
+
+#include "TempoMap.hpp"
+
+#include <cstdio>
+#include <random>
+
+namespace
+{
+	// A tempo change every half beat, with beat lengths that don't divide evenly into ticks.
+	// Some tempos are fast enough that several ticks fall within the same microsecond.
+	TempoMap MakeDenseTempoMap(std::size_t aTempoCount)
+	{
+		TempoMap tempoMap;
+		tempoMap.SetTicksPerQuarterNote(480);
+
+		for (std::size_t i = 0; i < aTempoCount; ++i)
+		{
+			const std::int64_t timePerBeat = (i % 100 == 99) ? 211 : 250'000 + static_cast<std::int64_t>((i * 7'919) % 500'000);
+			tempoMap.AddTempo(static_cast<std::uint32_t>(i) * 240, std::chrono::microseconds(timePerBeat));
+		}
+
+		return tempoMap;
+	}
+}
+
+void Benchmark::RunTempoMapBenchmarks()
+{
+	std::printf("== Tempo map\n");
+
+	constexpr std::size_t TempoCount = 10'000;
+	constexpr std::size_t QueryCount = 1'000'000;
+	constexpr std::size_t RunCount = 10;
+
+	const TempoMap tempoMap = MakeDenseTempoMap(TempoCount);
+	const std::uint32_t lastTick = tempoMap.GetSections().back().TickStart + 480;
+	const std::chrono::microseconds lastTime = tempoMap.TickToTime(lastTick);
+
+	// Fixed seed, so every run makes the same queries.
+	std::minstd_rand random(1);
+	std::vector<std::uint32_t> randomTicks(QueryCount);
+	std::vector<std::chrono::microseconds> randomTimes(QueryCount);
+	for (std::size_t i = 0; i < QueryCount; ++i)
+	{
+		randomTicks[i] = static_cast<std::uint32_t>(random() % lastTick);
+		randomTimes[i] = std::chrono::microseconds(static_cast<std::int64_t>(random()) % lastTime.count());
+	}
+
+	std::vector<std::uint32_t> sequentialTicks(QueryCount);
+	std::vector<std::chrono::microseconds> sequentialTimes(QueryCount);
+	for (std::size_t i = 0; i < QueryCount; ++i)
+	{
+		sequentialTicks[i] = static_cast<std::uint32_t>(static_cast<std::uint64_t>(i) * lastTick / QueryCount);
+		sequentialTimes[i] = std::chrono::microseconds(static_cast<std::int64_t>(i) * lastTime.count() / static_cast<std::int64_t>(QueryCount));
+	}
+
+	std::printf("%zu tempo changes, %zu queries\n", tempoMap.GetSections().size(), QueryCount);
+
+	const auto measureTicks = [&](const char* aName, const std::vector<std::uint32_t>& someTicks)
+		{
+			Report(aName, Measure(RunCount, [&]()
+				{
+					std::int64_t sum = 0;
+					for (const std::uint32_t tick : someTicks)
+						sum += tempoMap.TickToTime(tick).count();
+					Consume(static_cast<std::uint64_t>(sum));
+				}
+			), someTicks.size());
+		};
+
+	const auto measureTimes = [&](const char* aName, const std::vector<std::chrono::microseconds>& someTimes, auto aQuery)
+		{
+			Report(aName, Measure(RunCount, [&]()
+				{
+					double sum = 0.0;
+					for (const std::chrono::microseconds time : someTimes)
+						sum += static_cast<double>(aQuery(time));
+					Consume(static_cast<std::uint64_t>(sum));
+				}
+			), someTimes.size());
+		};
+
+	measureTicks("TickToTime, random", randomTicks);
+	measureTicks("TickToTime, sequential", sequentialTicks);
+	measureTimes("TimeToTick, random", randomTimes, [&](std::chrono::microseconds aTime) { return tempoMap.TimeToTick(aTime); });
+	measureTimes("TimeToTick, sequential", sequentialTimes, [&](std::chrono::microseconds aTime) { return tempoMap.TimeToTick(aTime); });
+	measureTimes("GetBeatsAt, random", randomTimes, [&](std::chrono::microseconds aTime) { return tempoMap.GetBeatsAt(aTime); });
+	measureTimes("GetBeatsAt, sequential", sequentialTimes, [&](std::chrono::microseconds aTime) { return tempoMap.GetBeatsAt(aTime); });
+
+	Report("Cursor::TickToTime, sequential", Measure(RunCount, [&]()
+		{
+			TempoMap::Cursor cursor(tempoMap);
+			std::int64_t sum = 0;
+			for (const std::uint32_t tick : sequentialTicks)
+				sum += cursor.TickToTime(tick).count();
+			Consume(static_cast<std::uint64_t>(sum));
+		}
+	), sequentialTicks.size());
+
+	Report("Cursor::TimeToTick, sequential", Measure(RunCount, [&]()
+		{
+			TempoMap::Cursor cursor(tempoMap);
+			std::uint64_t sum = 0;
+			for (const std::chrono::microseconds time : sequentialTimes)
+				sum += cursor.TimeToTick(time);
+			Consume(sum);
+		}
+	), sequentialTimes.size());
+
+	// Every tick has to come back from its time. Where several ticks share a microsecond, the last of them comes back.
+	bool isRoundTripExact = true;
+	bool isCursorMatching = true;
+	TempoMap::Cursor tickCursor(tempoMap);
+	TempoMap::Cursor timeCursor(tempoMap);
+	for (std::uint32_t tick = 0; tick <= lastTick && isRoundTripExact && isCursorMatching; ++tick)
+	{
+		const std::chrono::microseconds time = tempoMap.TickToTime(tick);
+		const std::uint32_t roundTrip = tempoMap.TimeToTick(time);
+		isRoundTripExact = roundTrip >= tick && tempoMap.TickToTime(roundTrip) == time && tempoMap.TickToTime(roundTrip + 1) > time;
+		isCursorMatching = tickCursor.TickToTime(tick) == time && timeCursor.TimeToTick(time) == roundTrip;
+
+		if (!isRoundTripExact || !isCursorMatching)
+			std::printf("  tick %u -> %lld us -> tick %u\n", tick, static_cast<long long>(time.count()), roundTrip);
+	}
+
+	Check("tick to time to tick round trip", isRoundTripExact);
+	Check("cursors match the tempo map", isCursorMatching);
+}
@@ -8,6 +8,8 @@
 
 #include "Atrium_GUI.hpp"
 
+#include <algorithm>
+
 void ChartAIController::HandleChartChange(const ChartData& aData)
 {
 	ChartController::HandleChartChange(aData);
@@ -153,141 +155,76 @@ void ChartAIController::RefreshGrips()
 	if (!track)
 		return;
 
-	const auto difficultyIterator = track->GetNoteRanges().find(GetTrackDifficulty());
-	if (difficultyIterator == track->GetNoteRanges().end())
-		return;
-
-	const std::vector<ChartNoteRange>& trackNotes = difficultyIterator->second;
+	const std::span<const ChartNoteRange> notes = track->GetNotes(GetTrackDifficulty());
+	const std::span<const ChartChord> chords = track->GetChords(GetTrackDifficulty());
 
-	for (const ChartNoteRange& note : trackNotes)
-		RefreshGrips_AddNote(note);
+	// Short notes are held for a while too, so the grip doesn't flicker between them.
+	std::vector<std::pair<std::chrono::microseconds, std::uint8_t>> noteEnds;
+	noteEnds.reserve(notes.size());
+	for (const ChartNoteRange& note : notes)
+		noteEnds.emplace_back(note.Start + Atrium::Math::Max(note.End - note.Start, std::chrono::microseconds(150'000)), note.Lane);
 
-	// Todo: Assert that the chord list is in order and has no overlap.
-}
-
-void ChartAIController::RefreshGrips_AddNote(const ChartNoteRange& aNote)
-{
-	ZoneScoped;
+	std::sort(noteEnds.begin(), noteEnds.end());
 
-	std::chrono::microseconds duration = aNote.End - aNote.Start;
-	duration = Atrium::Math::Max(duration, std::chrono::microseconds(150'000));
+	// Sweep the chord starts and note ends together. Every time a note starts or ends the grip changes,
+	// and between them the grip holds every lane that has a note on it.
+	std::array<std::uint32_t, 8> heldNotes = { };
+	std::uint32_t heldCount = 0;
 
-	const std::chrono::microseconds adjustedEnd = aNote.Start + duration;
+	std::chrono::microseconds gripStart(0);
+	StrumType gripType = StrumType::Never;
 
-	const auto chords = RefreshGrips_CreateOrGetChordBlocksAt(aNote.Start, adjustedEnd);
-
-	for (auto chord = chords.first; chord != chords.second; chord++)
+	std::size_t nextChord = 0;
+	std::size_t nextEnd = 0;
+	while (nextChord < chords.size() || nextEnd < noteEnds.size())
 	{
-		// Only the start of the note needs to be strummed.
-		if (chord == chords.first)
-		{
-		switch (aNote.Type)
-		{
-			case ChartNoteType::Strum:
-					chord->Type = StrumType::Always;
-				break;
-			case ChartNoteType::HOPO:
-					if (chord->Type == StrumType::Never)
-						chord->Type = StrumType::IfNoCombo;
-				break;
-		}
-		}
-
-		chord->Lanes.insert(aNote.Lane);
-	}
-}
-
-std::pair<std::vector<ChartAIController::ChordGrip>::iterator, std::vector<ChartAIController::ChordGrip>::iterator> ChartAIController::RefreshGrips_CreateOrGetChordBlocksAt(const std::chrono::microseconds& aStart, const std::chrono::microseconds& anEnd)
-{
-	ZoneScoped;
-
-	RefreshGrips_SplitChordAt(aStart);
-	RefreshGrips_SplitChordAt(anEnd);
+		std::chrono::microseconds time = (nextEnd < noteEnds.size()) ? noteEnds[nextEnd].first : chords[nextChord].Start;
+		if (nextChord < chords.size())
+			time = Atrium::Math::Min(time, chords[nextChord].Start);
 
-	auto startChord = std::find_if(
-		myGrips.begin(), myGrips.end(),
-		[&aStart](const ChordGrip& aChord)
+		if (heldCount > 0)
 		{
-			return (aChord.Start <= aStart && aStart < aChord.End) || aChord.Start > aStart;
-		}
-	);
-
-	// No chords after aStart, just create one.
-	if (startChord == myGrips.end())
-	{
-		ChordGrip& newChord = myGrips.emplace_back();
-		newChord.Start = aStart;
-		newChord.End = anEnd;
-		return { myGrips.end() - 1, myGrips.end() };
-	}
+			ChordGrip& grip = myGrips.emplace_back();
+			grip.Start = gripStart;
+			grip.End = time;
+			grip.Type = gripType;
 
-	// First chord started after aStart, need to fill the gap.
-	if (startChord->Start != aStart)
-	{
-		std::chrono::microseconds emptyBlockEnd = startChord->Start;
-		startChord = myGrips.emplace(startChord);
-		startChord->Start = aStart;
-		startChord->End = emptyBlockEnd;
-	}
+			for (std::uint8_t lane = 0; lane < heldNotes.size(); ++lane)
+			{
+				if (heldNotes[lane] > 0)
+					grip.Lanes.insert(lane);
+			}
+		}
 
-	// We got the first chord block in the range.
-	const std::size_t startChordIndex = static_cast<std::size_t>(startChord - myGrips.begin());
+		// Notes that carry on past a change don't need to be strummed again.
+		gripStart = time;
+		gripType = StrumType::Never;
 
-	// Time to find the last.
-	for (std::size_t i = startChordIndex; i < myGrips.size(); ++i)
-	{
-		const ChordGrip& currentChord = myGrips.at(i);
-
-		if (currentChord.End == anEnd)
+		for (; nextEnd < noteEnds.size() && noteEnds[nextEnd].first == time; ++nextEnd)
 		{
-			return { myGrips.begin() + startChordIndex, myGrips.begin() + i + 1 };
+			--heldNotes[noteEnds[nextEnd].second];
+			--heldCount;
 		}
 
-		if (i < (myGrips.size() - 1))
+		if (nextChord < chords.size() && chords[nextChord].Start == time)
 		{
-			const ChordGrip& nextChord = myGrips.at(i + 1);
-			if (currentChord.End != nextChord.Start)
+			const ChartChord& chord = chords[nextChord++];
+			for (const ChartNoteRange& note : notes.subspan(chord.FirstNote, chord.NoteCount))
 			{
-				const std::chrono::microseconds inbetweenEnd = nextChord.Start;
-				ChordGrip& inbetween = *myGrips.emplace(myGrips.begin() + (i + 1));
-				inbetween.Start = currentChord.End;
-				inbetween.End = inbetweenEnd;
+				++heldNotes[note.Lane];
+				++heldCount;
+
+				switch (note.Type)
+				{
+					case ChartNoteType::Strum:
+						gripType = StrumType::Always;
+						break;
+					case ChartNoteType::HOPO:
+						if (gripType == StrumType::Never)
+							gripType = StrumType::IfNoCombo;
+						break;
+				}
 			}
 		}
-		else
-		{
-			ChordGrip& endChord = myGrips.emplace_back();
-			endChord.Start = currentChord.End;
-			endChord.End = anEnd;
-			return { myGrips.begin() + startChordIndex, myGrips.end() };
-		}
 	}
-
-	throw std::out_of_range("Couldn't find or create the last chord.");
-}
-
-void ChartAIController::RefreshGrips_SplitChordAt(const std::chrono::microseconds& aTimepoint)
-{
-	ZoneScoped;
-
-	auto firstHalf = std::find_if(
-		myGrips.begin(), myGrips.end(),
-		[&aTimepoint](const ChordGrip& aChord)
-		{
-			return aChord.Start < aTimepoint && aTimepoint < aChord.End;
-		}
-	);
-
-	if (firstHalf == myGrips.end())
-		return;
-
-	if (firstHalf->Start == aTimepoint || firstHalf->End == aTimepoint)
-		return;
-
-	auto secondHalf = myGrips.emplace(firstHalf + 1, *firstHalf);
-	secondHalf->Start = aTimepoint;
-	(secondHalf - 1)->End = aTimepoint;
-
-	// After the split, the second chord will contain the same notes continued, and so doesn't need to be re-strummed.
-	secondHalf->Type = StrumType::Never;
 }
@@ -39,13 +39,8 @@ private:
 		StrumType Type = StrumType::Never;
 	};
 
+	// Builds the grips from the chord table, in time order and without overlaps.
 	void RefreshGrips();
 
-	void RefreshGrips_AddNote(const ChartNoteRange& aNote);
-
-	std::pair<std::vector<ChordGrip>::iterator, std::vector<ChordGrip>::iterator> RefreshGrips_CreateOrGetChordBlocksAt(const std::chrono::microseconds& aStart, const std::chrono::microseconds& anEnd);
-
-	void RefreshGrips_SplitChordAt(const std::chrono::microseconds& aTimepoint);
-
 	std::vector<ChordGrip> myGrips;
 };
\ No newline at end of file
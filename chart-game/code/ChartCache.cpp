@@ -0,0 +1,128 @@
+// Filter "Chart"
+#include "ChartCache.hpp"
+
+#include "Atrium_Diagnostics.hpp"
+
+#include <format>
+#include <fstream>
+
+// "CHRT" when read as bytes.
+static constexpr std::uint32_t CacheMagic = 0x54524843;
+
+ChartCache::Writer::Writer(std::uint64_t aHash)
+	: Writer(FileHeader { CacheMagic, Version })
+{
+	Write(aHash);
+}
+
+ChartCache::Writer::Writer(const FileHeader& aHeader)
+{
+	Write(aHeader.Magic);
+	Write(aHeader.Version);
+}
+
+void ChartCache::Writer::WriteString(std::string_view aString)
+{
+	WriteArray(std::span<const char>(aString.data(), aString.size()));
+}
+
+bool ChartCache::Writer::SaveToFile(const std::filesystem::path& aPath) const
+{
+	ZoneScoped;
+
+	std::error_code error;
+	if (aPath.has_parent_path())
+		std::filesystem::create_directories(aPath.parent_path(), error);
+
+	std::ofstream fileStream(aPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!fileStream.is_open())
+		return false;
+
+	fileStream.write(reinterpret_cast<const char*>(myData.data()), myData.size());
+	return fileStream.good();
+}
+
+bool ChartCache::Reader::ReadHeader(std::uint64_t anExpectedHash)
+{
+	if (!ReadHeader(FileHeader { CacheMagic, Version }))
+		return false;
+
+	std::uint64_t hash = 0;
+	Read(hash);
+	return hash == anExpectedHash;
+}
+
+bool ChartCache::Reader::ReadHeader(const FileHeader& anExpectedHeader)
+{
+	std::uint32_t magic = 0;
+	std::uint32_t version = 0;
+
+	Read(magic);
+	if (magic != anExpectedHeader.Magic)
+		return false;
+
+	Read(version);
+	return version == anExpectedHeader.Version;
+}
+
+void ChartCache::Reader::ReadString(std::string& outString)
+{
+	std::uint32_t length = 0;
+	Read(length);
+
+	const std::span<const std::uint8_t> bytes = Take(length);
+	outString.assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+std::span<const std::uint8_t> ChartCache::Reader::Take(std::size_t aByteCount)
+{
+	if (myData.size() < aByteCount)
+		throw std::runtime_error("Unexpected end of compiled chart data.");
+
+	const std::span<const std::uint8_t> bytes = myData.first(aByteCount);
+	myData = myData.subspan(aByteCount);
+	return bytes;
+}
+
+std::uint64_t ChartCache::Hash(std::span<const std::uint8_t> someData, std::uint64_t aSeed)
+{
+	ZoneScoped;
+
+	std::uint64_t hash = aSeed;
+	for (std::uint8_t byte : someData)
+	{
+		hash ^= byte;
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+std::filesystem::path ChartCache::GetPath(const std::filesystem::path& aSongFolder, std::uint64_t aHash, const std::filesystem::path& aCacheDirectory)
+{
+	if (aCacheDirectory.empty())
+		return aSongFolder / "notes.chart.bin";
+
+	return aCacheDirectory / std::format("{:016x}.chart.bin", aHash);
+}
+
+std::vector<std::uint8_t> ChartCache::ReadFile(const std::filesystem::path& aPath)
+{
+	ZoneScoped;
+
+	std::ifstream fileStream(aPath, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!fileStream.is_open())
+		return { };
+
+	const std::streamoff fileSize = fileStream.tellg();
+	if (fileSize < 0)
+		return { };
+
+	std::vector<std::uint8_t> fileData(static_cast<std::size_t>(fileSize));
+	fileStream.seekg(0, std::ios::beg);
+	fileStream.read(reinterpret_cast<char*>(fileData.data()), fileData.size());
+	if (static_cast<std::size_t>(fileStream.gcount()) != fileData.size())
+		return { };
+
+	return fileData;
+}
@@ -0,0 +1,123 @@
+// Filter "Chart"
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Compiled charts, a binary snapshot of fully processed chart data that can be loaded without parsing the MIDI again.
+// The data is stored in native byte order and layout, so it's only meant as a local cache.
+class ChartCache
+{
+public:
+	// Bump whenever anything that's written to the cache changes.
+	static constexpr std::uint32_t Version = 6;
+
+	// Identifies the kind of file and the version of its layout, for other files written in the same binary format.
+	struct FileHeader
+	{
+		std::uint32_t Magic = 0;
+		std::uint32_t Version = 0;
+	};
+
+	class Writer
+	{
+	public:
+		// Starts a compiled chart, made from sources with the given hash.
+		explicit Writer(std::uint64_t aHash);
+		explicit Writer(const FileHeader& aHeader);
+
+		template <typename T>
+		void Write(const T& aValue);
+
+		template <typename T>
+		void WriteArray(std::span<const T> someValues);
+
+		void WriteString(std::string_view aString);
+
+		bool SaveToFile(const std::filesystem::path& aPath) const;
+
+	private:
+		std::vector<std::uint8_t> myData;
+	};
+
+	class Reader
+	{
+	public:
+		Reader(std::span<const std::uint8_t> someData) : myData(someData) { }
+
+		// Checks that the data is a compiled chart of the current version, made from sources with the given hash.
+		bool ReadHeader(std::uint64_t anExpectedHash);
+		bool ReadHeader(const FileHeader& anExpectedHeader);
+
+		template <typename T>
+		void Read(T& outValue);
+
+		template <typename T>
+		void ReadArray(std::vector<T>& outValues);
+
+		void ReadString(std::string& outString);
+
+	private:
+		std::span<const std::uint8_t> Take(std::size_t aByteCount);
+
+		std::span<const std::uint8_t> myData;
+	};
+
+public:
+	// 64-bit FNV-1a, chainable by passing the previous hash as the seed.
+	static std::uint64_t Hash(std::span<const std::uint8_t> someData, std::uint64_t aSeed = 0xcbf29ce484222325ull);
+
+	// Without a cache directory the compiled chart is kept next to the song.
+	static std::filesystem::path GetPath(const std::filesystem::path& aSongFolder, std::uint64_t aHash, const std::filesystem::path& aCacheDirectory = {});
+
+	// Returns an empty buffer if the file doesn't exist or can't be read.
+	static std::vector<std::uint8_t> ReadFile(const std::filesystem::path& aPath);
+};
+
+template <typename T>
+inline void ChartCache::Writer::Write(const T& aValue)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be written as-is.");
+
+	const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(&aValue);
+	myData.insert(myData.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+inline void ChartCache::Writer::WriteArray(std::span<const T> someValues)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be written as-is.");
+
+	Write(static_cast<std::uint32_t>(someValues.size()));
+
+	const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(someValues.data());
+	myData.insert(myData.end(), bytes, bytes + someValues.size_bytes());
+}
+
+template <typename T>
+inline void ChartCache::Reader::Read(T& outValue)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be read as-is.");
+
+	std::memcpy(&outValue, Take(sizeof(T)).data(), sizeof(T));
+}
+
+template <typename T>
+inline void ChartCache::Reader::ReadArray(std::vector<T>& outValues)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be read as-is.");
+
+	std::uint32_t count = 0;
+	Read(count);
+
+	const std::span<const std::uint8_t> bytes = Take(static_cast<std::size_t>(count) * sizeof(T));
+	outValues.resize(count);
+	std::memcpy(outValues.data(), bytes.data(), bytes.size());
+}
@@ -0,0 +1,181 @@
+// Filter "Chart/Playback"
+#include "ChartCalibration.hpp"
+
+#include "ChartCache.hpp"
+#include "ChartData.hpp"
+
+#include "Atrium_Diagnostics.hpp"
+#include "Atrium_Math.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// "CCAL" when read as bytes.
+static constexpr std::uint32_t CalibrationMagic = 0x4C414343;
+
+// Scales a median absolute deviation to match the standard deviation of normally distributed samples.
+static constexpr double MedianDeviationScale = 1.4826;
+
+// Keeps samples that are nearly all the same, like inputs polled at a fixed rate, from rejecting everything else.
+static constexpr std::chrono::microseconds MinimumOutlierDistance = std::chrono::microseconds(1'000);
+
+static std::chrono::microseconds Median(std::vector<std::chrono::microseconds>& someValues)
+{
+	const auto middle = someValues.begin() + someValues.size() / 2;
+	std::nth_element(someValues.begin(), middle, someValues.end());
+
+	if (someValues.size() % 2 != 0)
+		return *middle;
+
+	const std::chrono::microseconds below = *std::max_element(someValues.begin(), middle);
+	return below + (*middle - below) / 2;
+}
+
+static std::chrono::microseconds MedianDeviation(std::span<const std::chrono::microseconds> someValues, std::chrono::microseconds aMedian)
+{
+	std::vector<std::chrono::microseconds> deviations;
+	deviations.reserve(someValues.size());
+	for (const std::chrono::microseconds value : someValues)
+		deviations.push_back(Atrium::Math::Abs(value - aMedian));
+
+	return Median(deviations);
+}
+
+std::optional<ChartCalibration::OffsetEstimate> ChartCalibration::EstimateOffset(std::span<const std::chrono::microseconds> someSamples)
+{
+	ZoneScoped;
+
+	if (someSamples.size() < MinimumSampleCount)
+		return { };
+
+	std::vector<std::chrono::microseconds> samples(someSamples.begin(), someSamples.end());
+	const std::chrono::microseconds median = Median(samples);
+	const std::chrono::microseconds deviation = MedianDeviation(someSamples, median);
+
+	const std::chrono::microseconds outlierDistance = Atrium::Math::Max(
+		MinimumOutlierDistance,
+		std::chrono::microseconds(static_cast<std::int64_t>(static_cast<double>(deviation.count()) * MedianDeviationScale * OutlierThreshold))
+	);
+
+	samples.assign(someSamples.begin(), someSamples.end());
+	std::erase_if(samples, [&](std::chrono::microseconds aSample) { return Atrium::Math::Abs(aSample - median) > outlierDistance; });
+
+	if (samples.size() < MinimumSampleCount)
+		return { };
+
+	OffsetEstimate estimate;
+	estimate.SampleCount = samples.size();
+	estimate.RejectedCount = someSamples.size() - samples.size();
+	estimate.Offset = Median(samples);
+	estimate.Deviation = MedianDeviation(samples, estimate.Offset);
+	return estimate;
+}
+
+std::vector<std::chrono::microseconds> ChartCalibration::GetTapOffsets(std::span<const std::chrono::microseconds> someTaps, const ChartData& aChart)
+{
+	const std::vector<ChartData::Beat>& beats = aChart.GetBeats();
+
+	std::vector<std::chrono::microseconds> offsets;
+	if (beats.empty())
+		return offsets;
+
+	offsets.reserve(someTaps.size());
+	for (const std::chrono::microseconds tap : someTaps)
+	{
+		if (tap < beats.front().Time || beats.back().Time < tap)
+			continue;
+
+		const auto after = std::lower_bound(
+			beats.begin(), beats.end(), tap,
+			[](const ChartData::Beat& aBeat, std::chrono::microseconds aTime) { return aBeat.Time < aTime; }
+		);
+
+		std::chrono::microseconds offset = tap - after->Time;
+		if (after != beats.begin() && (tap - (after - 1)->Time) < Atrium::Math::Abs(offset))
+			offset = tap - (after - 1)->Time;
+
+		offsets.push_back(offset);
+	}
+
+	return offsets;
+}
+
+std::chrono::microseconds ChartCalibration::GetInputOffset(std::string_view aDevice) const
+{
+	const auto offset = myInputOffsets.find(aDevice);
+	return offset != myInputOffsets.end() ? offset->second : std::chrono::microseconds(0);
+}
+
+void ChartCalibration::SetInputOffset(std::string_view aDevice, std::chrono::microseconds anOffset)
+{
+	myInputOffsets.insert_or_assign(std::string(aDevice), anOffset);
+}
+
+bool ChartCalibration::Load(const std::filesystem::path& aPath)
+{
+	const std::vector<std::uint8_t> data = ChartCache::ReadFile(aPath);
+	if (data.empty())
+		return false;
+
+	try
+	{
+		ChartCache::Reader reader(data);
+		if (!reader.ReadHeader(ChartCache::FileHeader { CalibrationMagic, FileVersion }))
+			return false;
+
+		std::int64_t hitWindow = 0;
+		std::int64_t audioVideoOffset = 0;
+		reader.Read(hitWindow);
+		reader.Read(audioVideoOffset);
+
+		if (hitWindow <= 0)
+			throw std::runtime_error("Hit window has to be longer than zero.");
+
+		std::uint32_t deviceCount = 0;
+		reader.Read(deviceCount);
+
+		std::map<std::string, std::chrono::microseconds, std::less<>> inputOffsets;
+		for (std::uint32_t i = 0; i < deviceCount; ++i)
+		{
+			std::string device;
+			std::int64_t offset = 0;
+			reader.ReadString(device);
+			reader.Read(offset);
+			inputOffsets.insert_or_assign(std::move(device), std::chrono::microseconds(offset));
+		}
+
+		myHitWindow = std::chrono::microseconds(hitWindow);
+		myAudioVideoOffset = std::chrono::microseconds(audioVideoOffset);
+		myInputOffsets = std::move(inputOffsets);
+	}
+	catch (const std::exception& anException)
+	{
+		Atrium::Debug::LogWarning("Couldn't load calibration from %s: %s", aPath.string().c_str(), anException.what());
+		return false;
+	}
+
+	return true;
+}
+
+bool ChartCalibration::Save(const std::filesystem::path& aPath) const
+{
+	ChartCache::Writer writer(ChartCache::FileHeader { CalibrationMagic, FileVersion });
+
+	writer.Write(static_cast<std::int64_t>(myHitWindow.count()));
+	writer.Write(static_cast<std::int64_t>(myAudioVideoOffset.count()));
+
+	writer.Write(static_cast<std::uint32_t>(myInputOffsets.size()));
+	for (const auto& [device, offset] : myInputOffsets)
+	{
+		writer.WriteString(device);
+		writer.Write(static_cast<std::int64_t>(offset.count()));
+	}
+
+	if (!writer.SaveToFile(aPath))
+	{
+		Atrium::Debug::LogWarning("Couldn't write calibration to %s", aPath.string().c_str());
+		return false;
+	}
+
+	return true;
+}
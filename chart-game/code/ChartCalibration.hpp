@@ -0,0 +1,72 @@
+// Filter "Chart/Playback"
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ChartData;
+
+// Timing corrections for the player's setup, used when judging inputs and when drawing the chart.
+class ChartCalibration
+{
+public:
+	// Bump whenever the layout of the calibration file changes.
+	static constexpr std::uint32_t FileVersion = 2;
+
+	static constexpr std::chrono::microseconds DefaultHitWindow = std::chrono::microseconds(300'000);
+
+	// Estimates from fewer samples than this are too easily thrown off to be used.
+	static constexpr std::size_t MinimumSampleCount = 8;
+
+	// Samples further than this many scaled median absolute deviations from the median are left out of estimates.
+	static constexpr double OutlierThreshold = 3.0;
+
+	struct OffsetEstimate
+	{
+		std::chrono::microseconds Offset;
+		// Median absolute deviation of the samples that were kept, as a measure of how consistent they were.
+		std::chrono::microseconds Deviation;
+		std::size_t SampleCount = 0;
+		std::size_t RejectedCount = 0;
+	};
+
+	// The median of someSamples, after rejecting outliers based on the median absolute deviation.
+	static std::optional<OffsetEstimate> EstimateOffset(std::span<const std::chrono::microseconds> someSamples);
+
+	// How far each tap is from the beat closest to it, for estimating offsets from tapping along to a chart.
+	// Taps before the first beat or after the last are skipped.
+	static std::vector<std::chrono::microseconds> GetTapOffsets(std::span<const std::chrono::microseconds> someTaps, const ChartData& aChart);
+
+	static std::filesystem::path GetDefaultPath() { return "calibration.bin"; }
+
+public:
+	// How far from a note an input can be and still hit it.
+	std::chrono::microseconds GetHitWindow() const { return myHitWindow; }
+	void SetHitWindow(std::chrono::microseconds aHitWindow) { myHitWindow = aHitWindow; }
+
+	// How much later the picture is shown than the audio is heard. Notes are drawn this much ahead to line them up again.
+	std::chrono::microseconds GetAudioVideoOffset() const { return myAudioVideoOffset; }
+	void SetAudioVideoOffset(std::chrono::microseconds anOffset) { myAudioVideoOffset = anOffset; }
+
+	// How much later inputs from aDevice arrive than they were played. Devices without an offset are taken to have none.
+	std::chrono::microseconds GetInputOffset(std::string_view aDevice) const;
+	void SetInputOffset(std::string_view aDevice, std::chrono::microseconds anOffset);
+
+	const std::map<std::string, std::chrono::microseconds, std::less<>>& GetInputOffsets() const { return myInputOffsets; }
+
+	bool Load(const std::filesystem::path& aPath);
+	bool Save(const std::filesystem::path& aPath) const;
+
+private:
+	std::chrono::microseconds myHitWindow = DefaultHitWindow;
+	std::chrono::microseconds myAudioVideoOffset = std::chrono::microseconds(0);
+	std::map<std::string, std::chrono::microseconds, std::less<>> myInputOffsets;
+};
@@ -59,3 +59,25 @@ struct ChartNoteRange
 		return (End - Start) >= std::chrono::microseconds(10'000);
 	}
 };
+
+// The notes of a difficulty that start at the same time.
+struct ChartChord
+{
+	std::chrono::microseconds Start = std::chrono::microseconds(0);
+	// When the longest of its notes ends.
+	std::chrono::microseconds SustainEnd = std::chrono::microseconds(0);
+
+	// The chord's notes, as a range in the difficulty's sorted notes.
+	std::uint32_t FirstNote = 0;
+	std::uint32_t NoteCount = 0;
+
+	// One bit per lane.
+	std::uint8_t Lanes = 0;
+	// The type of the chord's first note. Notes that start together normally share one.
+	ChartNoteType Type = ChartNoteType::Strum;
+
+	bool IsChord() const
+	{
+		return (Lanes & (Lanes - 1)) != 0;
+	}
+};
@@ -7,31 +7,25 @@
 
 #include "Atrium_GUI.hpp"
 
-static std::chrono::microseconds NoteLowestAccuracy = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::milliseconds(300));
+static const ChartCalibration DefaultCalibration;
 
 ChartController::ChartController()
 	: myTrackDifficulty(ChartTrackDifficulty::Hard)
 	, myTrackType(ChartTrackType::LeadGuitar)
+	, myCalibration(&DefaultCalibration)
 {
 	myLaneStates.fill(false);
+	myLaneCursors.fill(0);
+	myLastPlayhead = std::chrono::microseconds(0);
 }
 
 std::optional<std::chrono::microseconds> ChartController::GetNoteHitEnd(const ChartNoteRange& aNoteRange) const
 {
-	for (const auto it : myHitNoteRanges)
-	{
-		const bool isSame
-			= (it.first == &aNoteRange)
-			|| (it.first->Lane == aNoteRange.Lane
-			&& it.first->Start == aNoteRange.Start
-			&& it.first->End == aNoteRange.End)
-			;
-
-		if (isSame)
-			return it.second;
-	}
+	const std::optional<std::uint32_t> noteIndex = FindNoteIndex(aNoteRange);
+	if (!noteIndex || !myNoteJudgements[noteIndex.value()].IsHit)
+		return { };
 
-	return { };
+	return myNoteJudgements[noteIndex.value()].SustainEnd;
 }
 
 void ChartController::HandleChartChange(const ChartData& aData)
@@ -44,18 +38,42 @@ void ChartController::HandleChartChange(const ChartData& aData)
 
 	myLastPlayhead = std::chrono::microseconds(0);
 	myLastStrum.reset();
+	myQueuedInputs.clear();
 
-	myLastLaneHitCheck.clear();
-	myActiveSustains.clear();
-	myHitNoteRanges.clear();
+	myLaneCursors.fill(0);
+	ResetJudgements();
+
+	myInputRecording = { };
+	RestartRecording();
 }
 
 void ChartController::HandlePlayheadStep(const std::chrono::microseconds& aPrevious, const std::chrono::microseconds& aNew)
 {
-	if (aNew >= aPrevious)
+	// Replays judge everything with the calibration in effect when they're saved, so changing it starts the recording over.
+	if (myIsRecordingInputs && (GetHitWindow() != myRecordingHitWindow || GetInputOffset() != myRecordingInputOffset))
+		RestartRecording();
+
+	// Inputs come in late by the input offset, so judging trails behind the playhead by as much.
+	// That way late inputs can still be judged at the time they were played.
+	const std::chrono::microseconds inputOffset = GetInputOffset();
+	const std::chrono::microseconds previous = aPrevious - inputOffset;
+	const std::chrono::microseconds next = aNew - inputOffset;
+
+	if (myIsRecordingInputs)
+	{
+		if (next < previous)
+			myInputRecording = { };
+
+		myInputRecording.Steps.emplace_back(aPrevious, aNew);
+	}
+
+	if (next >= previous)
 	{
-		UpdateActiveSustains(aPrevious, aNew);
-		CheckUnhitNotes(aNew);
+		myLastPlayhead = previous;
+		JudgeQueuedInputs(next);
+
+		UpdateActiveSustains(myLastPlayhead, next);
+		CheckUnhitNotes(next);
 	}
 	else
 	{
@@ -67,13 +85,49 @@ void ChartController::HandlePlayheadStep(const std::chrono::microseconds& aPrevi
 		myLaneStates.fill(false);
 		myLaneLastStrum.fill(std::chrono::microseconds(0));
 		myLastStrum.reset();
+		myQueuedInputs.clear();
 
-		myLastLaneHitCheck.clear();
-		myActiveSustains.clear();
-		myHitNoteRanges.clear();
+		ResetLaneCursors(next);
+		ResetJudgements();
 	}
 
-	myLastPlayhead = aNew;
+	myLastPlayhead = next;
+}
+
+void ChartController::HandleQueuedInputs(std::chrono::microseconds aPlayhead)
+{
+	JudgeQueuedInputs(aPlayhead - GetInputOffset());
+}
+
+void ChartController::JudgeQueuedInputs(std::chrono::microseconds aTimepoint)
+{
+	std::size_t handledCount = 0;
+	for (; handledCount < myQueuedInputs.size() && myQueuedInputs[handledCount].Time <= aTimepoint; ++handledCount)
+	{
+		const TimedInput& input = myQueuedInputs[handledCount];
+
+		// Catch up to the input first, so it's judged against the same state as if the playhead had stopped right there.
+		// Inputs that arrive too late for that are judged as soon as possible instead.
+		const std::chrono::microseconds inputTime = Atrium::Math::Max(input.Time, myLastPlayhead);
+		UpdateActiveSustains(myLastPlayhead, inputTime);
+		CheckUnhitNotes(inputTime);
+		myLastPlayhead = inputTime;
+
+		switch (input.Type)
+		{
+			case TimedInput::Action::PressLane:
+				SetLane(input.Lane, true);
+				break;
+			case TimedInput::Action::ReleaseLane:
+				SetLane(input.Lane, false);
+				break;
+			case TimedInput::Action::Strum:
+				Strum();
+				break;
+		}
+	}
+
+	myQueuedInputs.erase(myQueuedInputs.begin(), myQueuedInputs.begin() + handledCount);
 }
 
 #if IS_IMGUI_ENABLED
@@ -95,10 +149,6 @@ void ChartController::ImGui(ChartTestWindow& aTestWindow)
 	{
 		SetTrackDifficulty(ChartTrackDifficulty(currentDifficulty));
 	}
-
-	int currentLowestAccuracyMilliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(NoteLowestAccuracy).count());
-	if (ImGui::InputInt("Lowest accuracy (ms): ", &currentLowestAccuracyMilliseconds, 50, 500))
-		NoteLowestAccuracy = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::milliseconds(currentLowestAccuracyMilliseconds));
 }
 
 void ChartController::ImGui_Scoring()
@@ -118,9 +168,7 @@ void ChartController::CheckTapHit(std::uint8_t aLane)
 	if (track == nullptr)
 		return;
 
-	const std::chrono::microseconds lastHitCheck = myLastLaneHitCheck.contains(aLane) ? myLastLaneHitCheck.at(aLane) : std::chrono::microseconds(0);
-
-	const ChartNoteRange* nextNote = track->GetNextNote(GetTrackDifficulty(), aLane, lastHitCheck);
+	const ChartNoteRange* nextNote = GetLaneCursorNote(*track, aLane);
 	if (!nextNote)
 		return;
 
@@ -135,12 +183,8 @@ void ChartController::CheckTapHit(std::uint8_t aLane)
 	if (!accuracy.has_value())
 		return;
 
-	if (nextNote->IsSustain())
-		myActiveSustains.insert(nextNote);
-
-	myHitNoteRanges[nextNote] = nextNote->IsSustain() ? nextNote->Start : nextNote->End;
+	HitNote(*track, static_cast<std::uint32_t>(nextNote - track->GetNotes(GetTrackDifficulty()).data()), myLastPlayhead);
 	myScoring.HitValidNotes(1);
-	myLastLaneHitCheck[aLane] = myLastPlayhead;
 }
 
 void ChartController::CheckStrumHits()
@@ -153,41 +197,98 @@ void ChartController::CheckStrumHits()
 
 	const std::uint8_t laneCount = ChartTrackTypeLaneCount[static_cast<int>(GetTrackType())];
 
-	bool overStrummed = false;
+	// Lanes held down for a sustain may be held on top of the strummed chord.
+	const std::span<const ChartNoteRange> notes = track->GetNotes(GetTrackDifficulty());
+	std::uint8_t sustainedLanes = 0;
+	for (const std::uint32_t sustain : myActiveSustains)
+		sustainedLanes |= static_cast<std::uint8_t>(1u << notes[sustain].Lane);
 
+	std::uint8_t heldLanes = 0;
+	std::optional<std::chrono::microseconds> earliestUnjudged;
 	for (std::uint8_t lane = 0; lane < laneCount; ++lane)
 	{
-		if (myLaneStates[lane] == false)
-			continue;
-
-		const std::chrono::microseconds lastHitCheck = myLastLaneHitCheck.contains(lane) ? myLastLaneHitCheck.at(lane) : std::chrono::microseconds(0);
+		if (const ChartNoteRange* note = GetLaneCursorNote(*track, lane))
+			earliestUnjudged = earliestUnjudged ? Atrium::Math::Min(earliestUnjudged.value(), note->Start) : note->Start;
 
-		const ChartNoteRange* nextNote = track->GetNextNote(GetTrackDifficulty(), lane, lastHitCheck);
-		if (!nextNote)
-			continue;
+		if (myLaneStates[lane])
+			heldLanes |= static_cast<std::uint8_t>(1u << lane);
+	}
 
-		// Assumes strumming a note is never incorrect.
+	if (heldLanes == 0 || !earliestUnjudged)
+		return;
 
-		const std::optional<float> accuracy = CalculateNoteAccuracy(nextNote->Start, myLastStrum.value());
+	// Chords that start before the hit window can't be strummed anymore, so there's no need to look at them.
+	const std::span<const ChartChord> chords = track->GetChords(GetTrackDifficulty());
+	const ChartChord* chord = track->GetNextChord(GetTrackDifficulty(), Atrium::Math::Max(earliestUnjudged.value(), myLastStrum.value() - GetHitWindow()));
 
-		if (accuracy)
+	// A chord can still be strummed if none of its lanes have been judged past it.
+	const auto isUnjudged = [&](const ChartChord& aChord)
+	{
+		for (std::uint8_t lane = 0; lane < laneCount; ++lane)
 		{
-			if (nextNote->IsSustain())
-				myActiveSustains.insert(nextNote);
+			if ((aChord.Lanes & (1u << lane)) == 0)
+				continue;
 
-			myHitNoteRanges[nextNote] = nextNote->IsSustain() ? nextNote->Start : nextNote->End;
-			myScoring.HitValidNotes(1);
+			const ChartNoteRange* note = GetLaneCursorNote(*track, lane);
+			if (note == nullptr || note->Start > aChord.Start)
+				return false;
 		}
-		else
+		return true;
+	};
+
+	// Chords need exactly their lanes held. Single notes also allow holding lower lanes, like on a real guitar.
+	const auto isHeld = [heldLanes, sustainedLanes](const ChartChord& aChord)
+	{
+		const std::uint8_t allowedLanes = (aChord.IsChord() ? aChord.Lanes : static_cast<std::uint8_t>((aChord.Lanes << 1) - 1)) | sustainedLanes;
+		return (heldLanes & aChord.Lanes) == aChord.Lanes && (heldLanes & ~allowedLanes) == 0;
+	};
+
+	// The strum goes to the first chord in the hit window that's being held, skipping over any that weren't played.
+	const ChartChord* strummedChord = nullptr;
+	for (; chord != nullptr && chord != chords.data() + chords.size() && chord->Start <= myLastStrum.value() + GetHitWindow(); ++chord)
+	{
+		if (isUnjudged(*chord) && isHeld(*chord))
 		{
-			overStrummed = true;
+			strummedChord = chord;
+			break;
 		}
-
-		myLastLaneHitCheck[lane] = myLastPlayhead;
 	}
 
-	if (overStrummed)
+	if (strummedChord == nullptr || !CalculateNoteAccuracy(strummedChord->Start, myLastStrum.value()))
+	{
 		myScoring.HitInvalidNotes();
+		return;
+	}
+
+	// Anything that was skipped to get to this chord can't be played anymore.
+	unsigned int missedNotes = 0;
+	for (std::uint8_t lane = 0; lane < laneCount; ++lane)
+	{
+		while (const ChartNoteRange* note = GetLaneCursorNote(*track, lane))
+		{
+			if (note->Start >= strummedChord->Start)
+				break;
+
+			myNoteJudgements[note - notes.data()].IsMissed = true;
+			++myLaneCursors[lane];
+			++missedNotes;
+		}
+	}
+
+	if (missedNotes > 0)
+		myScoring.MissedValidNotes(missedNotes);
+
+	// Notes in a lane never overlap, so a sustain in a lane that's strummed again is over.
+	for (std::size_t i = myActiveSustains.size(); i-- > 0;)
+	{
+		if ((strummedChord->Lanes & (1u << notes[myActiveSustains[i]].Lane)) != 0)
+			EndSustain(myActiveSustains[i]);
+	}
+
+	for (std::uint32_t noteIndex = strummedChord->FirstNote; noteIndex < strummedChord->FirstNote + strummedChord->NoteCount; ++noteIndex)
+		HitNote(*track, noteIndex, myLastStrum.value());
+
+	myScoring.HitValidNotes(strummedChord->NoteCount);
 }
 
 void ChartController::CheckUnhitNotes(std::chrono::microseconds aNewPlayhead)
@@ -197,28 +298,129 @@ void ChartController::CheckUnhitNotes(std::chrono::microseconds aNewPlayhead)
 		return;
 
 	const std::uint8_t laneCount = ChartTrackTypeLaneCount[static_cast<int>(GetTrackType())];
-	
+	const std::span<const ChartNoteRange> notes = track->GetNotes(GetTrackDifficulty());
+
 	for (std::uint8_t lane = 0; lane < laneCount; ++lane)
 	{
-		const std::chrono::microseconds lastHitCheck = myLastLaneHitCheck.contains(lane) ? myLastLaneHitCheck.at(lane) : std::chrono::microseconds(0);
+		const std::span<const std::uint32_t> laneNotes = track->GetLaneNotes(GetTrackDifficulty(), lane);
+		std::uint32_t& cursor = myLaneCursors[lane];
 
-		const ChartNoteRange* nextNote = track->GetNextNote(GetTrackDifficulty(), lane, lastHitCheck);
-		if (!nextNote)
-			continue;
-
-		if ((nextNote->Start + NoteLowestAccuracy) < aNewPlayhead)
+		unsigned int missedNotes = 0;
+		while (cursor < laneNotes.size() && (notes[laneNotes[cursor]].Start + GetHitWindow()) < aNewPlayhead)
 		{
-			myScoring.MissedValidNotes(1);
-			myLastLaneHitCheck[lane] = aNewPlayhead;
+			myNoteJudgements[laneNotes[cursor]].IsMissed = true;
+			++missedNotes;
+			++cursor;
 		}
+
+		if (missedNotes > 0)
+			myScoring.MissedValidNotes(missedNotes);
 	}
 }
 
+const ChartNoteRange* ChartController::GetLaneCursorNote(const ChartTrack& aTrack, std::uint8_t aLane) const
+{
+	const std::span<const std::uint32_t> laneNotes = aTrack.GetLaneNotes(GetTrackDifficulty(), aLane);
+	if (myLaneCursors[aLane] >= laneNotes.size())
+		return nullptr;
+
+	return &aTrack.GetNotes(GetTrackDifficulty())[laneNotes[myLaneCursors[aLane]]];
+}
+
+void ChartController::ResetLaneCursors(std::chrono::microseconds aTimepoint)
+{
+	myLaneCursors.fill(0);
+
+	const ChartTrack* track = GetTrack();
+	if (track == nullptr)
+		return;
+
+	const std::uint8_t laneCount = ChartTrackTypeLaneCount[static_cast<int>(GetTrackType())];
+	const std::span<const ChartNoteRange> notes = track->GetNotes(GetTrackDifficulty());
+	const std::chrono::microseconds hitWindow = GetHitWindow();
+
+	for (std::uint8_t lane = 0; lane < laneCount; ++lane)
+	{
+		const std::span<const std::uint32_t> laneNotes = track->GetLaneNotes(GetTrackDifficulty(), lane);
+		const auto firstHittable = std::lower_bound(
+			laneNotes.begin(), laneNotes.end(), aTimepoint,
+			[&notes, hitWindow](std::uint32_t aNote, std::chrono::microseconds aTimepoint) { return (notes[aNote].Start + hitWindow) < aTimepoint; }
+		);
+
+		myLaneCursors[lane] = static_cast<std::uint32_t>(firstHittable - laneNotes.begin());
+	}
+}
+
+void ChartController::ResetJudgements()
+{
+	myActiveSustains.clear();
+
+	const ChartTrack* track = GetTrack();
+	myNoteJudgements.resize(track ? track->GetNotes(GetTrackDifficulty()).size() : 0);
+	std::fill(myNoteJudgements.begin(), myNoteJudgements.end(), NoteJudgement { });
+}
+
+std::optional<std::uint32_t> ChartController::FindNoteIndex(const ChartNoteRange& aNoteRange) const
+{
+	const ChartTrack* track = GetTrack();
+	if (track == nullptr)
+		return { };
+
+	const std::span<const ChartNoteRange> notes = track->GetNotes(GetTrackDifficulty());
+
+	// Notes are normally handed out straight from the track, so their address gives their index.
+	if (&aNoteRange >= notes.data() && &aNoteRange < notes.data() + notes.size())
+		return static_cast<std::uint32_t>(&aNoteRange - notes.data());
+
+	const auto firstAtStart = std::lower_bound(
+		notes.begin(), notes.end(), aNoteRange.Start,
+		[](const ChartNoteRange& aNote, std::chrono::microseconds aStart) { return aNote.Start < aStart; }
+	);
+
+	for (auto note = firstAtStart; note != notes.end() && note->Start == aNoteRange.Start; ++note)
+	{
+		if (note->Lane == aNoteRange.Lane && note->End == aNoteRange.End)
+			return static_cast<std::uint32_t>(note - notes.begin());
+	}
+
+	return { };
+}
+
+void ChartController::HitNote(const ChartTrack& aTrack, std::uint32_t aNoteIndex, std::chrono::microseconds aHitTimepoint)
+{
+	const ChartNoteRange& note = aTrack.GetNotes(GetTrackDifficulty())[aNoteIndex];
+
+	NoteJudgement& judgement = myNoteJudgements[aNoteIndex];
+	judgement.IsHit = true;
+	judgement.HitTime = aHitTimepoint;
+	judgement.SustainEnd = note.IsSustain() ? note.Start : note.End;
+
+	if (note.IsSustain())
+	{
+		judgement.IsSustaining = true;
+		myActiveSustains.push_back(aNoteIndex);
+	}
+
+	++myLaneCursors[note.Lane];
+}
+
+void ChartController::EndSustain(std::uint32_t aNoteIndex)
+{
+	myNoteJudgements[aNoteIndex].IsSustaining = false;
+	std::erase(myActiveSustains, aNoteIndex);
+}
+
+std::chrono::microseconds ChartController::GetInputOffset() const
+{
+	const char* device = GetInputDevice();
+	return device != nullptr ? myCalibration->GetInputOffset(device) : std::chrono::microseconds(0);
+}
+
 std::optional<float> ChartController::CalculateNoteAccuracy(std::chrono::microseconds aPerfectTimepoint, std::chrono::microseconds aHitTimepoint) const
 {
 	const std::chrono::microseconds accuracyMilliseconds = Atrium::Math::Abs(aHitTimepoint - aPerfectTimepoint);
 
-	const float accuracy = 1 - (static_cast<float>(accuracyMilliseconds.count()) / static_cast<float>(NoteLowestAccuracy.count()));
+	const float accuracy = 1 - (static_cast<float>(accuracyMilliseconds.count()) / static_cast<float>(GetHitWindow().count()));
 
 	if (accuracy < 0.f || accuracy > 1.f)
 		return { };
@@ -227,65 +429,103 @@ std::optional<float> ChartController::CalculateNoteAccuracy(std::chrono::microse
 }
 
 void ChartController::UpdateActiveSustains(const std::chrono::microseconds& aPreviousPlayhead, const std::chrono::microseconds& aNewPlayhead)
-{	
-	for (auto sustainIt : myActiveSustains)
-		myHitNoteRanges[sustainIt] = aNewPlayhead;
+{
+	if (myActiveSustains.empty())
+		return;
 
-	while (true)
-	{
-		const auto activeSustainInLane = std::find_if(
-			myActiveSustains.begin(),
-			myActiveSustains.end(),
-			[&aNewPlayhead](const ChartNoteRange* aNote) { return aNote->End < aNewPlayhead; }
-		);
+	const std::span<const ChartNoteRange> notes = GetTrack()->GetNotes(GetTrackDifficulty());
 
-		if (activeSustainInLane == myActiveSustains.end())
-			break;
+	for (std::size_t i = myActiveSustains.size(); i-- > 0;)
+	{
+		const std::uint32_t sustain = myActiveSustains[i];
+		myNoteJudgements[sustain].SustainEnd = aNewPlayhead;
 
-		myScoring.SustainProgress(*myCurrentChart, aPreviousPlayhead, (*activeSustainInLane)->End);
-		myActiveSustains.erase(activeSustainInLane);
+		if (notes[sustain].End < aNewPlayhead)
+		{
+			myScoring.SustainProgress(*myCurrentChart, aPreviousPlayhead, notes[sustain].End);
+			EndSustain(sustain);
+		}
 	}
 
-	for (auto sustainIt : myActiveSustains)
-		myLaneLastStrum[sustainIt->Lane] = aNewPlayhead;
+	for (const std::uint32_t sustain : myActiveSustains)
+		myLaneLastStrum[notes[sustain].Lane] = aNewPlayhead;
 
 	myScoring.SustainProgress(*myCurrentChart, aPreviousPlayhead, aNewPlayhead, myActiveSustains.size());
 }
 
 bool ChartController::IsSustainActive(const ChartNoteRange& aNoteRange) const
 {
-	const auto activeSustain = std::find_if(
-		myActiveSustains.begin(),
-		myActiveSustains.end(),
-		[&aNoteRange](const ChartNoteRange* aNote)
-		{
-			return
-				aNoteRange.Lane == aNote->Lane
-				&& aNoteRange.Start == aNote->Start
-				&& aNoteRange.End == aNote->End
-				;
-		}
+	const std::optional<std::uint32_t> noteIndex = FindNoteIndex(aNoteRange);
+	return noteIndex && myNoteJudgements[noteIndex.value()].IsSustaining;
+}
+
+bool ChartController::IsNoteMissed(const ChartNoteRange& aNoteRange) const
+{
+	const std::optional<std::uint32_t> noteIndex = FindNoteIndex(aNoteRange);
+	return noteIndex && myNoteJudgements[noteIndex.value()].IsMissed;
+}
+
+void ChartController::QueueInput(const TimedInput& anInput)
+{
+	if (myIsRecordingInputs)
+		myInputRecording.Inputs.push_back(anInput);
+
+	TimedInput input = anInput;
+	input.Time -= GetInputOffset();
+
+	const auto insertPoint = std::upper_bound(
+		myQueuedInputs.begin(), myQueuedInputs.end(), input.Time,
+		[](std::chrono::microseconds aTime, const TimedInput& anInput) { return aTime < anInput.Time; }
 	);
 
-	return activeSustain != myActiveSustains.end();
+	myQueuedInputs.insert(insertPoint, input);
 }
 
-bool ChartController::IsNoteMissed(const ChartNoteRange& aNoteRange) const
+void ChartController::SetRecordingInputs(bool aState)
 {
-	if (myLastPlayhead < aNoteRange.Start)
-		return false;
+	if (aState == myIsRecordingInputs)
+		return;
 
-	return !CalculateNoteAccuracy(aNoteRange.Start, myLastPlayhead).has_value();
+	myIsRecordingInputs = aState;
+	RestartRecording();
+}
+
+void ChartController::SetRecordingTaps(bool aState)
+{
+	if (aState && !myIsRecordingTaps)
+		myRecordedTaps.clear();
+
+	myIsRecordingTaps = aState;
+}
+
+void ChartController::RestartRecording()
+{
+	if (!myIsRecordingInputs)
+		return;
+
+	myRecordingHitWindow = GetHitWindow();
+	myRecordingInputOffset = GetInputOffset();
+
+	// Replays are judged by a fresh controller with the settings in effect when they're saved,
+	// so judging starts over from here, the same as seeking back to it.
+	const std::chrono::microseconds playhead = myLastPlayhead + GetInputOffset();
+	HandlePlayheadStep(playhead + std::chrono::microseconds(1), playhead);
 }
 
 void ChartController::SetTrackType(ChartTrackType aType)
 {
 	myTrackType = aType;
+	ResetLaneCursors(myLastPlayhead);
+	ResetJudgements();
+	RestartRecording();
 }
 
 void ChartController::SetTrackDifficulty(ChartTrackDifficulty aDifficulty)
 {
 	myTrackDifficulty = aDifficulty;
+	ResetLaneCursors(myLastPlayhead);
+	ResetJudgements();
+	RestartRecording();
 }
 
 void ChartController::ClearLanes()
@@ -312,16 +552,17 @@ void ChartController::SetLane(std::uint8_t aLane, bool aState)
 
 	myLaneStates.at(aLane) = aState;
 
-	if (!aState)
+	if (!aState && !myActiveSustains.empty())
 	{
+		const std::span<const ChartNoteRange> notes = GetTrack()->GetNotes(GetTrackDifficulty());
 		const auto activeSustainInLane = std::find_if(
 			myActiveSustains.begin(),
 			myActiveSustains.end(),
-			[&aLane](const ChartNoteRange* aNote) { return aNote->Lane == aLane; }
+			[&](std::uint32_t aNote) { return notes[aNote].Lane == aLane; }
 		);
 
 		if (activeSustainInLane != myActiveSustains.end())
-			myActiveSustains.erase(activeSustainInLane);
+			EndSustain(*activeSustainInLane);
 	}
 }
 
@@ -329,6 +570,9 @@ void ChartController::Strum()
 {
 	myLastStrum = myLastPlayhead;
 
+	if (myIsRecordingTaps)
+		myRecordedTaps.push_back(myLastPlayhead);
+
 	for (std::size_t i = 0; i < myLaneStates.size(); ++i)
 	{
 		if (!myLaneStates[i])
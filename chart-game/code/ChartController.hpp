@@ -1,6 +1,7 @@
 // Filter "Chart/Playback"
 #pragma once
 
+#include "ChartCalibration.hpp"
 #include "ChartCommonStructures.hpp"
 #include "ChartScoring.hpp"
 
@@ -8,8 +9,8 @@
 
 #include <array>
 #include <chrono>
-#include <set>
 #include <span>
+#include <vector>
 
 class ChartData;
 class ChartTestWindow;
@@ -17,6 +18,26 @@ class ChartTrack;
 
 class ChartController
 {
+public:
+	// A lane or strum change, stamped with the chart time it happened at.
+	struct TimedInput
+	{
+		enum class Action : std::uint8_t { PressLane, ReleaseLane, Strum };
+
+		std::chrono::microseconds Time;
+		Action Type = Action::Strum;
+		std::uint8_t Lane = 0;
+	};
+
+	// Everything that went into judging a stretch of play, to be able to judge it again the same way.
+	struct InputRecording
+	{
+		// The previous and new playhead of each step.
+		std::vector<std::pair<std::chrono::microseconds, std::chrono::microseconds>> Steps;
+		// As they were queued, before correcting for the input offset.
+		std::vector<TimedInput> Inputs;
+	};
+
 public:
 	ChartController();
 	virtual ~ChartController() = default;
@@ -25,6 +46,14 @@ public:
 
 	virtual const char* GetName() const = 0;
 
+	// The input device this controller is played with, to look up its offset in the calibration. Null if it has no offset.
+	virtual const char* GetInputDevice() const { return nullptr; }
+
+	const ChartCalibration& GetCalibration() const { return *myCalibration; }
+
+	// The calibration has to outlive the controller, or be replaced before it's destroyed.
+	void SetCalibration(const ChartCalibration& aCalibration) { myCalibration = &aCalibration; }
+
 	std::optional<std::chrono::microseconds> GetNoteHitEnd(const ChartNoteRange& aNoteRange) const;
 
 	std::span<const bool> GetLaneStates() const { return myLaneStates; }
@@ -38,7 +67,11 @@ public:
 
 	virtual void HandleChartChange(const ChartData& aData);
 	virtual void HandlePlayheadStep(const std::chrono::microseconds& aPrevious, const std::chrono::microseconds& aNew);
-	virtual void HandleInput([[maybe_unused]] const Atrium::InputEvent& anInputEvent) { }
+	virtual void HandleInput([[maybe_unused]] const Atrium::InputEvent& anInputEvent, [[maybe_unused]] std::chrono::microseconds aTimepoint) { }
+
+	// Judges the queued inputs up to aPlayhead without moving further.
+	// Playhead steps do this as they go, this is for when the playhead isn't moving.
+	void HandleQueuedInputs(std::chrono::microseconds aPlayhead);
 
 	#if IS_IMGUI_ENABLED
 	virtual void ImGui(ChartTestWindow& aTestWindow);
@@ -47,6 +80,23 @@ public:
 	bool IsSustainActive(const ChartNoteRange& aNoteRange) const;
 	bool IsNoteMissed(const ChartNoteRange& aNoteRange) const;
 
+	// While recording, the time of every strum is kept, to estimate the input offset from tapping along to the beat.
+	// The times are already corrected by the current offset, so estimates from them are how much it's still off by.
+	void SetRecordingTaps(bool aState);
+	bool IsRecordingTaps() const { return myIsRecordingTaps; }
+	std::span<const std::chrono::microseconds> GetRecordedTaps() const { return myRecordedTaps; }
+
+	// While recording, playhead steps and queued inputs are kept for replays. Inputs that don't go through QueueInput aren't recorded.
+	// Starting a recording resets the score, as does seeking back or changing the chart, track, difficulty or calibration while recording,
+	// which start the recording over from there.
+	void SetRecordingInputs(bool aState);
+	bool IsRecordingInputs() const { return myIsRecordingInputs; }
+	const InputRecording& GetInputRecording() const { return myInputRecording; }
+
+	// Inputs are judged in time order as the playhead passes them, rather than at the time of the next update.
+	// anInput is corrected by the input offset of the controller's device.
+	void QueueInput(const TimedInput& anInput);
+
 	virtual void SetTrackType(ChartTrackType aType);
 	virtual void SetTrackDifficulty(ChartTrackDifficulty aDifficulty);
 
@@ -66,6 +116,30 @@ private:
 	void CheckStrumHits();
 	void CheckUnhitNotes(std::chrono::microseconds aNewPlayhead);
 
+	// Judges the queued inputs up to aTimepoint, catching up to each one first.
+	void JudgeQueuedInputs(std::chrono::microseconds aTimepoint);
+
+	// The note at the lane's cursor, or null if every note in the lane has been judged.
+	const ChartNoteRange* GetLaneCursorNote(const ChartTrack& aTrack, std::uint8_t aLane) const;
+
+	// Moves every lane's cursor to the first note that can still be hit at aTimepoint.
+	void ResetLaneCursors(std::chrono::microseconds aTimepoint);
+
+	// Forgets every hit and miss, sized for the current track and difficulty.
+	void ResetJudgements();
+
+	// Starts the input recording over from the last playhead, if recording.
+	void RestartRecording();
+
+	// Position of aNoteRange in the current difficulty's notes, if it's one of them.
+	std::optional<std::uint32_t> FindNoteIndex(const ChartNoteRange& aNoteRange) const;
+
+	void HitNote(const ChartTrack& aTrack, std::uint32_t aNoteIndex, std::chrono::microseconds aHitTimepoint);
+	void EndSustain(std::uint32_t aNoteIndex);
+
+	std::chrono::microseconds GetHitWindow() const { return myCalibration->GetHitWindow(); }
+	std::chrono::microseconds GetInputOffset() const;
+
 	std::optional<float> CalculateNoteAccuracy(std::chrono::microseconds aPerfectTimepoint, std::chrono::microseconds aHitTimepoint) const;
 
 	void UpdateActiveSustains(const std::chrono::microseconds& aPreviousPlayhead, const std::chrono::microseconds& aNewPlayhead);
@@ -74,6 +148,7 @@ private:
 	ChartTrackType myTrackType;
 	ChartTrackDifficulty myTrackDifficulty;
 	const ChartData* myCurrentChart = nullptr;
+	const ChartCalibration* myCalibration;
 
 	std::array<bool, 10> myLaneStates;
 	std::array<std::chrono::microseconds, 10> myLaneLastStrum;
@@ -81,10 +156,35 @@ private:
 	std::chrono::microseconds myLastPlayhead;
 	std::optional<std::chrono::microseconds> myLastStrum;
 
-	// Per lane, the timepoint we've checked hits and misses up until.
-	std::map<std::uint8_t, std::chrono::microseconds> myLastLaneHitCheck;
-
-	std::set<const ChartNoteRange*> myActiveSustains;
-
-	std::map<const ChartNoteRange*, std::chrono::microseconds> myHitNoteRanges;
+	// Sorted by time.
+	std::vector<TimedInput> myQueuedInputs;
+
+	bool myIsRecordingInputs = false;
+	InputRecording myInputRecording;
+	// The calibration the recording was started with, to tell when it changes.
+	std::chrono::microseconds myRecordingHitWindow = std::chrono::microseconds(0);
+	std::chrono::microseconds myRecordingInputOffset = std::chrono::microseconds(0);
+
+	bool myIsRecordingTaps = false;
+	std::vector<std::chrono::microseconds> myRecordedTaps;
+
+	// Per lane, the position in the track's lane notes of the next note that hasn't been hit or missed yet.
+	// These only move forward during play, and are repositioned when seeking back or switching tracks.
+	std::array<std::uint32_t, 10> myLaneCursors;
+
+	struct NoteJudgement
+	{
+		std::chrono::microseconds HitTime;
+		// How far the note has been played. For sustains this follows the playhead while they're held.
+		std::chrono::microseconds SustainEnd;
+		bool IsHit;
+		bool IsMissed;
+		bool IsSustaining;
+	};
+
+	// One per note of the current difficulty, in the same order as the track's notes.
+	std::vector<NoteJudgement> myNoteJudgements;
+
+	// Indices of the notes whose sustains are being held. There's at most one per lane.
+	std::vector<std::uint32_t> myActiveSustains;
 };
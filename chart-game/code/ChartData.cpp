@@ -1,12 +1,13 @@
 // Filter "Chart"
 #include "ChartData.hpp"
+#include "ChartLoadArena.hpp"
 
 #include "MidiDecoder.hpp"
+#include "WorkerPool.hpp"
 
 #include "Atrium_Diagnostics.hpp"
-#include "Atrium_Math.hpp"
 
-#define MIDI_DEFAULT_TEMPO (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::minutes(1)) * 120);
+#include <algorithm>
 
 void ChartInfo::Load(const std::filesystem::path& aSongIni)
 {
@@ -34,39 +35,71 @@ void ChartInfo::Load(const std::filesystem::path& aSongIni)
 	myDifficulties[ChartTrackType::Vocal_Harmony] = song.Has("diff_vocals_harm") ? song.Get<int>("diff_vocals_harm") : -1;
 }
 
-std::chrono::microseconds ChartData::GetBeatLengthAt(std::chrono::microseconds aTime) const
+void ChartInfo::LoadCache(ChartCache::Reader& aReader)
 {
-	std::chrono::microseconds currentTempo = MIDI_DEFAULT_TEMPO;
-	for (const auto& it : myTempos)
+	aReader.ReadString(mySongInfo.Title);
+	aReader.ReadString(mySongInfo.Artist);
+	aReader.ReadString(mySongInfo.Album);
+	aReader.ReadString(mySongInfo.Genre);
+	aReader.Read(mySongInfo.Year);
+	aReader.Read(mySongInfo.SongLength);
+
+	std::uint32_t count = 0;
+	aReader.Read(count);
+
+	myDifficulties.clear();
+	for (std::uint32_t i = 0; i < count; ++i)
 	{
-		if (it.TimeStart <= aTime)
-			currentTempo = it.TimePerBeat;
-		else
-			break;
+		ChartTrackType track = ChartTrackType::LeadGuitar;
+		int difficulty = -1;
+		aReader.Read(track);
+		aReader.Read(difficulty);
+		myDifficulties[track] = difficulty;
 	}
+}
 
-	return currentTempo;
+void ChartInfo::SaveCache(ChartCache::Writer& aWriter) const
+{
+	aWriter.WriteString(mySongInfo.Title);
+	aWriter.WriteString(mySongInfo.Artist);
+	aWriter.WriteString(mySongInfo.Album);
+	aWriter.WriteString(mySongInfo.Genre);
+	aWriter.Write(mySongInfo.Year);
+	aWriter.Write(mySongInfo.SongLength);
+
+	aWriter.Write(static_cast<std::uint32_t>(myDifficulties.size()));
+	for (const auto& [track, difficulty] : myDifficulties)
+	{
+		aWriter.Write(track);
+		aWriter.Write(difficulty);
+	}
 }
 
-float ChartData::GetBeatsInPeriod(std::chrono::microseconds aFrom, std::chrono::microseconds aTo) const
+std::chrono::microseconds ChartData::GetBeatLengthAt(std::chrono::microseconds aTime) const
 {
-	float totalBeats = 0.f;
+	const std::vector<TempoSection>& tempos = myTempoMap.GetSections();
+	if (tempos.empty() || aTime < tempos.front().TimeStart)
+		return TempoMap::DefaultTimePerBeat;
 
-	for (std::size_t i = 0; i < myTempos.size(); ++i)
-	{
-		const TempoSection& tempoSection = myTempos.at(i);
+	return tempos[myTempoMap.FindSectionByTime(aTime)].TimePerBeat;
+}
 
-		const std::chrono::microseconds sectionOverlapStart = Atrium::Math::Max(aFrom, tempoSection.TimeStart);
-		const std::chrono::microseconds sectionOverlapEnd = (myTempos.size() > (i + 1) ? Atrium::Math::Min(aTo, myTempos.at(i + 1).TimeStart) : aTo);
+float ChartData::GetBeatsInPeriod(std::chrono::microseconds aFrom, std::chrono::microseconds aTo) const
+{
+	if (aTo <= aFrom)
+		return 0.f;
 
-		if (sectionOverlapEnd <= sectionOverlapStart)
-			continue;
+	return static_cast<float>(myTempoMap.GetBeatsAt(aTo) - myTempoMap.GetBeatsAt(aFrom));
+}
 
-		const std::chrono::microseconds overlapTime = sectionOverlapEnd - sectionOverlapStart;
-		totalBeats += static_cast<float>(overlapTime.count()) / static_cast<float>(tempoSection.TimePerBeat.count());
-	}
+std::span<const ChartData::Beat> ChartData::GetBeatsInRange(std::chrono::microseconds aFrom, std::chrono::microseconds aTo) const
+{
+	const auto isBefore = [](const Beat& aBeat, std::chrono::microseconds aTime) { return aBeat.Time < aTime; };
+	const auto isAfter = [](std::chrono::microseconds aTime, const Beat& aBeat) { return aTime < aBeat.Time; };
 
-	return totalBeats;
+	const auto first = std::lower_bound(myBeats.begin(), myBeats.end(), aFrom, isBefore);
+	const auto last = std::upper_bound(first, myBeats.end(), aTo, isAfter);
+	return std::span<const Beat>(first, last);
 }
 
 float ChartData::GetBPMAt(std::chrono::microseconds aTime) const
@@ -76,41 +109,94 @@ float ChartData::GetBPMAt(std::chrono::microseconds aTime) const
 
 std::chrono::microseconds ChartData::GetDuration() const
 {
-	if (!myTempos.empty())
-		return myTempos.back().TimeStart;
+	if (!myTempoMap.GetSections().empty())
+		return myTempoMap.GetSections().back().TimeStart;
 	else
 		return std::chrono::microseconds(0);
 }
 
 const std::string ChartData::GetSectionNameAt(std::chrono::microseconds aTime) const
 {
-	const std::string* currentSection = nullptr;
-	for (const auto& it : mySections)
-	{
-		if (it.first <= aTime)
-			currentSection = &it.second;
-		else
-			break;
-	}
+	const auto next = std::upper_bound(
+		mySections.begin(), mySections.end(), aTime,
+		[](std::chrono::microseconds aTime, const auto& aSection) { return aTime < aSection.first; }
+	);
 
-	return currentSection ? *currentSection : "";
+	return next != mySections.begin() ? std::prev(next)->second : "";
 }
 
 const ChartData::TimeSignature ChartData::GetTimeSignatureAt(std::chrono::microseconds aTime) const
 {
-	const TimeSignature* currentTimeSignature = nullptr;
-	for (const auto& it : myTimeSignatures)
+	const auto next = std::upper_bound(
+		myTimeSignatures.begin(), myTimeSignatures.end(), aTime,
+		[](std::chrono::microseconds aTime, const auto& aTimeSignature) { return aTime < aTimeSignature.first; }
+	);
+
+	return next != myTimeSignatures.begin() ? std::prev(next)->second : TimeSignature();
+}
+
+struct ChartData::TrackChunkResult
+{
+	std::unique_ptr<ChartTrack> Track;
+	std::vector<std::pair<std::uint32_t, TimeSignature>> TimeSignatures;
+	std::vector<std::pair<std::chrono::microseconds, std::string>> Sections;
+	std::uint32_t EndTick = 0;
+	ChartLoadArena::Statistics Memory;
+};
+
+bool ChartData::Load(const std::filesystem::path& aSongIni, const std::filesystem::path& aCacheDirectory, LoadStatus* aStatus)
+{
+	ZoneScoped;
 	{
-		if (it.first <= aTime)
-			currentTimeSignature = &it.second;
-		else
-			break;
+		const std::string pathString = aSongIni.string();
+		ZoneText(pathString.c_str(), pathString.size());
 	}
 
-	return currentTimeSignature ? *currentTimeSignature : TimeSignature();
+	const std::vector<std::uint8_t> midiData = MidiDecoder::ReadFile(aSongIni.parent_path() / "notes.mid");
+	const std::uint64_t hash = ChartCache::Hash(ChartCache::ReadFile(aSongIni), ChartCache::Hash(midiData));
+	const std::filesystem::path cachePath = ChartCache::GetPath(aSongIni.parent_path(), hash, aCacheDirectory);
+
+	if (aStatus && aStatus->IsCancelled())
+		return false;
+
+	const std::vector<std::uint8_t> cacheData = ChartCache::ReadFile(cachePath);
+	if (!cacheData.empty())
+	{
+		try
+		{
+			ChartCache::Reader reader(cacheData);
+			if (reader.ReadHeader(hash))
+			{
+				LoadCache(reader);
+				myHash = hash;
+
+				if (aStatus)
+					aStatus->SetProgress(1.f);
+				return true;
+			}
+		}
+		catch (const std::exception& anException)
+		{
+			Atrium::Debug::LogWarning("Couldn't load compiled chart, falling back to MIDI: %s", anException.what());
+		}
+	}
+
+	if (!LoadMidiData(midiData, TrackFilter().set(), aStatus))
+		return false;
+
+	myHash = hash;
+
+	ChartCache::Writer writer(hash);
+	SaveCache(writer);
+	if (!writer.SaveToFile(cachePath))
+		Atrium::Debug::LogWarning("Couldn't write compiled chart to %s", cachePath.string().c_str());
+
+	if (aStatus)
+		aStatus->SetProgress(1.f);
+	return true;
 }
 
-void ChartData::LoadMidi(const std::filesystem::path& aMidi)
+bool ChartData::LoadMidi(const std::filesystem::path& aMidi, const TrackFilter& someTracks, LoadStatus* aStatus)
 {
 	ZoneScoped;
 	{
@@ -118,129 +204,387 @@ void ChartData::LoadMidi(const std::filesystem::path& aMidi)
 		ZoneText(pathString.c_str(), pathString.size());
 	}
 
-	myTempos.clear();
+	const std::vector<std::uint8_t> midiData = MidiDecoder::ReadFile(aMidi);
+	if (!LoadMidiData(midiData, someTracks, aStatus))
+		return false;
+
+	myHash = ChartCache::Hash(midiData);
+	return true;
+}
+
+void ChartData::Clear()
+{
+	myHash = 0;
+	myTempoMap.Clear();
 	mySections.clear();
 	myTimeSignatures.clear();
+	myBeats.clear();
 	myTracks.clear();
+}
 
-	MidiDecoder decoder;
+void ChartData::LoadCache(ChartCache::Reader& aReader)
+{
+	ZoneScoped;
 
-	std::uint16_t ticksPerQuarterNote(0);
-	MidiDecoder::FormatType formatType = MidiDecoder::FormatType::SingleTrack;
+	Clear();
 
-	std::unique_ptr<ChartTrack> currentTrack;
-	ChartTrackLoadData currentTrackLoadData;
+	std::uint16_t ticksPerQuarterNote = 0;
+	std::vector<TempoSection> tempos;
+	aReader.Read(ticksPerQuarterNote);
+	aReader.ReadArray(tempos);
 
-	auto ticksToTime = [&](std::uint32_t aTick) -> std::chrono::microseconds
-		{
-			std::chrono::microseconds totalTimeAtTick(0);
+	myTempoMap.SetTicksPerQuarterNote(ticksPerQuarterNote);
+	for (const TempoSection& tempo : tempos)
+	{
+		if (!myTempoMap.AddTempo(tempo.TickStart, tempo.TimePerBeat))
+			throw std::runtime_error("Compiled chart has a tempo with a zero beat length.");
+	}
 
-			for (auto tempoSection = myTempos.begin(); tempoSection != myTempos.end(); ++tempoSection)
-			{
-				if (tempoSection->TickStart > aTick)
-					break;
+	std::uint32_t count = 0;
+	aReader.Read(count);
+	myTimeSignatures.resize(count);
+	for (auto& [time, timeSignature] : myTimeSignatures)
+	{
+		aReader.Read(time);
+		aReader.Read(timeSignature);
+	}
 
-				auto nextTempoSection = tempoSection + 1;
-				const std::chrono::microseconds microsecondsPerTick(tempoSection->TimePerBeat / ticksPerQuarterNote);
+	aReader.Read(count);
+	mySections.resize(count);
+	for (auto& [time, name] : mySections)
+	{
+		aReader.Read(time);
+		aReader.ReadString(name);
+	}
 
-				const bool isContainingSection = (nextTempoSection == myTempos.end() || (tempoSection->TickStart <= aTick && aTick < nextTempoSection->TickStart));
+	aReader.ReadArray(myBeats);
 
-				std::int64_t sectionTickCount = ((isContainingSection ? aTick : nextTempoSection->TickStart) - tempoSection->TickStart);
-				totalTimeAtTick += std::chrono::microseconds(sectionTickCount * microsecondsPerTick);
-			}
+	aReader.Read(count);
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		ChartTrackType trackType = ChartTrackType::LeadGuitar;
+		aReader.Read(trackType);
 
-			return totalTimeAtTick;
-		};
+		std::unique_ptr<ChartTrack> track = ChartTrack::CreateTrack(trackType);
+		if (!track)
+			throw std::runtime_error("Compiled chart has an unsupported track.");
+
+		track->LoadCache(aReader);
+		myTracks[trackType] = std::move(track);
+	}
+}
+
+void ChartData::SaveCache(ChartCache::Writer& aWriter) const
+{
+	ZoneScoped;
+
+	aWriter.Write(myTempoMap.GetTicksPerQuarterNote());
+	aWriter.WriteArray(std::span<const TempoSection>(myTempoMap.GetSections()));
+
+	aWriter.Write(static_cast<std::uint32_t>(myTimeSignatures.size()));
+	for (const auto& [time, timeSignature] : myTimeSignatures)
+	{
+		aWriter.Write(time);
+		aWriter.Write(timeSignature);
+	}
+
+	aWriter.Write(static_cast<std::uint32_t>(mySections.size()));
+	for (const auto& [time, name] : mySections)
+	{
+		aWriter.Write(time);
+		aWriter.WriteString(name);
+	}
+
+	aWriter.WriteArray(std::span<const Beat>(myBeats));
+
+	aWriter.Write(static_cast<std::uint32_t>(myTracks.size()));
+	for (const auto& [trackType, track] : myTracks)
+	{
+		aWriter.Write(trackType);
+		track->SaveCache(aWriter);
+	}
+}
+
+bool ChartData::LoadMidiData(std::span<const std::uint8_t> someData, const TrackFilter& someTracks, LoadStatus* aStatus)
+{
+	ZoneScoped;
 
-	decoder.OnNewTrack.Connect(this, [&]()
+	Clear();
+
+	std::uint16_t ticksPerQuarterNote(0);
+	MidiDecoder::FormatType formatType = MidiDecoder::FormatType::SingleTrack;
+
+	std::vector<std::span<const std::uint8_t>> trackChunks;
+	for (const MidiDecoder::Chunk& chunk : MidiDecoder::FindChunks(someData))
+	{
+		switch (chunk.Type)
 		{
-			currentTrackLoadData = ChartTrackLoadData();
-			currentTrack.reset();
+		case MidiDecoder::ChunkType::Header:
+			MidiDecoder().ProcessHeaderChunk(chunk.GetData(someData), formatType, ticksPerQuarterNote);
+			break;
+		case MidiDecoder::ChunkType::Track:
+			trackChunks.push_back(chunk.GetData(someData));
+			break;
+		default:
+			break;
 		}
-	);
+	}
+
+	if (trackChunks.empty())
+		return true;
 
-	decoder.OnTrackName.Connect(this, [&](std::uint32_t, const std::string& aText)
+	// Skip decoding tracks that won't be used, based on their names alone.
+	// The first track is always kept for its tempo map.
+	const auto isTrackWanted = [&someTracks](std::span<const std::uint8_t> aChunk)
 		{
-			if (aText.starts_with("PART "))
-			{
-				ZoneScoped;
-				currentTrack = ChartTrack::CreateTrackByName(aText.substr(5));
+			const std::optional<std::string_view> trackName = MidiDecoder::FindTrackName(aChunk);
+			if (!trackName.has_value())
+				return true;
 
-				if (currentTrack && myTracks.contains(currentTrack->GetType()))
-				{
-					Atrium::Debug::LogError("Duplicate track won't be processed.");
-					currentTrack.reset();
-				}
-			}
-		}
+			if (trackName.value() == "EVENTS")
+				return true;
+
+			if (!trackName.value().starts_with("PART "))
+				return false;
+
+			const std::optional<ChartTrackType> trackType = ChartTrack::GetTrackTypeByName(trackName.value().substr(5));
+			return trackType.has_value() && someTracks.test(static_cast<std::size_t>(trackType.value()));
+		};
+
+	trackChunks.erase(
+		std::remove_if(trackChunks.begin() + 1, trackChunks.end(), [&](std::span<const std::uint8_t> aChunk) { return !isTrackWanted(aChunk); }),
+		trackChunks.end()
 	);
 
-	decoder.OnNote.Connect(this, [&](std::uint32_t aTick, std::uint8_t /*aChannel*/, std::uint8_t aNote, std::uint8_t aVelocity)
+	// Every track needs the tempo map for its tick to time conversion, so read that from the first track up front.
+	myTempoMap.SetTicksPerQuarterNote(ticksPerQuarterNote);
+	for (const MidiDecoder::Event& event : MidiDecoder::ReadTrackEvents(trackChunks.front()))
+	{
+		if (event.Type != MidiDecoder::EventType::Meta || event.Meta != MidiDecoder::MetaType::SetTempo)
+			continue;
+
+		if (!myTempoMap.AddTempo(event.Tick, std::chrono::microseconds(event.GetTempo())))
+			Atrium::Debug::LogWarning("Skipping tempo change with a zero beat length at tick %u.", event.Tick);
+	}
+
+	std::vector<TrackChunkResult> trackResults(trackChunks.size());
+
+	std::atomic<std::size_t> loadedTracks = 0;
+	WorkerPool::GetShared().ForEach(trackChunks.size(), [&](std::size_t anIndex)
 		{
-			currentTrackLoadData.AddNote(ticksToTime(aTick), aNote, aVelocity);
+			if (aStatus && aStatus->IsCancelled())
+				return;
+
+			LoadTrackChunk(trackChunks[anIndex], trackResults[anIndex]);
+
+			if (aStatus)
+				aStatus->SetProgress(0.9f * static_cast<float>(++loadedTracks) / static_cast<float>(trackChunks.size()));
 		}
 	);
 
-	decoder.OnSysEx.Connect(this, [&](std::uint32_t aTick, const std::span<const std::uint8_t>& someData)
+	if (aStatus && aStatus->IsCancelled())
+		return false;
+
+	std::vector<std::pair<std::uint32_t, TimeSignature>> timeSignatures;
+	std::uint32_t endTick = 0;
+	ChartLoadArena::Statistics memory;
+
+	// Merge in file order, so the result matches decoding the tracks one after another.
+	for (TrackChunkResult& result : trackResults)
+	{
+		memory += result.Memory;
+		timeSignatures.insert(timeSignatures.end(), result.TimeSignatures.begin(), result.TimeSignatures.end());
+		endTick = std::max(endTick, result.EndTick);
+		mySections.insert(mySections.end(), std::make_move_iterator(result.Sections.begin()), std::make_move_iterator(result.Sections.end()));
+
+		if (!result.Track)
+			continue;
+
+		if (myTracks.contains(result.Track->GetType()))
 		{
-			currentTrackLoadData.AddSysEx(ticksToTime(aTick), someData);
+			Atrium::Debug::LogError("Duplicate track won't be processed.");
+			continue;
 		}
-	);
 
-	decoder.OnText.Connect(this, [&](std::uint32_t aTick, const std::string& aText)
+		myTracks[result.Track->GetType()] = std::move(result.Track);
+	}
+
+	// Lookups binary search these, so they have to be in time order even if several tracks added to them.
+	const auto isEarlier = [](const auto& aLeft, const auto& aRight) { return aLeft.first < aRight.first; };
+	std::stable_sort(timeSignatures.begin(), timeSignatures.end(), isEarlier);
+	std::stable_sort(mySections.begin(), mySections.end(), isEarlier);
+
+	myTimeSignatures.reserve(timeSignatures.size());
+	for (const auto& [tick, timeSignature] : timeSignatures)
+		myTimeSignatures.emplace_back(myTempoMap.TickToTime(tick), timeSignature);
+
+	BuildBeats(timeSignatures, endTick);
+
+	if (aStatus)
+		aStatus->SetMemory(memory);
+	return true;
+}
+
+void ChartData::BuildBeats(const std::vector<std::pair<std::uint32_t, TimeSignature>>& someTimeSignatures, std::uint32_t anEndTick)
+{
+	ZoneScoped;
+
+	// Charts without a time signature are in 4/4.
+	TimeSignature timeSignature;
+	timeSignature.Numerator = 4;
+	timeSignature.Denominator = 4;
+
+	const std::uint32_t ticksPerQuarterNote = myTempoMap.GetTicksPerQuarterNote();
+	auto getBeatTicks = [&]() { return (ticksPerQuarterNote * 4u) / std::max<std::uint32_t>(timeSignature.Denominator, 1u); };
+
+	myBeats.reserve(anEndTick / std::max(getBeatTicks(), 1u) + 1);
+
+	TempoMap::Cursor tempoCursor(myTempoMap);
+	std::size_t nextTimeSignature = 0;
+	std::uint32_t beatInMeasure = 0;
+	std::uint32_t measure = 0;
+
+	for (std::uint32_t tick = 0; tick <= anEndTick;)
+	{
+		// A time signature change always starts a new measure, even if the previous one wasn't finished.
+		if (nextTimeSignature < someTimeSignatures.size() && someTimeSignatures[nextTimeSignature].first <= tick)
 		{
-			std::string::const_iterator nameStart, nameEnd;
-			if (aText.starts_with("[section"))
-			{
-				nameStart = aText.cbegin() + 9;
-				nameEnd = aText.cend() - 1;
-			}
-			else if (aText.starts_with("[prc_"))
+			while (nextTimeSignature < someTimeSignatures.size() && someTimeSignatures[nextTimeSignature].first <= tick)
+				timeSignature = someTimeSignatures[nextTimeSignature++].second;
+
+			if (beatInMeasure != 0)
 			{
-				nameStart = aText.cbegin() + 5;
-				nameEnd = aText.cend() - 1;
+				beatInMeasure = 0;
+				++measure;
 			}
-
-			mySections.emplace_back(ticksToTime(aTick), std::string(nameStart, nameEnd));
 		}
-	);
 
-	decoder.OnLyric.Connect(this, [&](std::uint32_t aTick, const std::string& aText)
+		Beat& beat = myBeats.emplace_back();
+		beat.Time = tempoCursor.TickToTime(tick);
+		beat.Tick = tick;
+		beat.Index = static_cast<std::uint32_t>(myBeats.size() - 1);
+		beat.Measure = measure;
+		beat.IsDownbeat = (beatInMeasure == 0);
+
+		if (++beatInMeasure >= std::max<std::uint8_t>(timeSignature.Numerator, 1))
 		{
-			currentTrackLoadData.AddLyric(ticksToTime(aTick), aText);
+			beatInMeasure = 0;
+			++measure;
 		}
-	);
 
-	decoder.OnTrackEnd.Connect(this, [&](std::uint32_t)
+		std::uint32_t nextTick = tick + std::max(getBeatTicks(), 1u);
+		if (nextTimeSignature < someTimeSignatures.size())
+			nextTick = std::min(nextTick, someTimeSignatures[nextTimeSignature].first);
+
+		tick = nextTick;
+	}
+}
+
+void ChartData::LoadTrackChunk(std::span<const std::uint8_t> aChunk, TrackChunkResult& outResult) const
+{
+	ZoneScoped;
+
+	// Everything staged here is thrown away once the track is loaded, so it all comes from one arena.
+	// Declared first, so it outlives everything allocated from it.
+	const ChartLoadArena::Handle arena = ChartLoadArena::Acquire();
+
+	std::unique_ptr<ChartTrack> currentTrack;
+	ChartTrackLoadData currentTrackLoadData(arena->GetResource());
+	currentTrackLoadData.Tempos = &myTempoMap;
+
+	// Events come in tick order, so the cursor only ever steps forward.
+	TempoMap::Cursor tempoCursor(myTempoMap);
+	auto ticksToTime = [&tempoCursor](std::uint32_t aTick) { return tempoCursor.TickToTime(aTick); };
+
+	auto handleText = [&](std::uint32_t aTick, std::string_view aText)
 		{
-			if (!currentTrack)
+			if (aText.find("ENHANCED_OPENS") != std::string_view::npos)
+			{
+				currentTrackLoadData.EnhancedOpens = true;
 				return;
+			}
 
-			if (currentTrack->Load(currentTrackLoadData) && !myTracks.contains(currentTrack->GetType()))
-				myTracks[currentTrack->GetType()] = std::move(currentTrack);
+			std::string_view name;
+			if (aText.starts_with("[section ") && aText.ends_with("]"))
+				name = aText.substr(9, aText.size() - 10);
+			else if (aText.starts_with("[prc_") && aText.ends_with("]"))
+				name = aText.substr(5, aText.size() - 6);
+			else
+				return;
 
-			currentTrack.reset();
-		}
-	);
+			outResult.Sections.emplace_back(ticksToTime(aTick), std::string(name));
+		};
 
-	decoder.OnSetTempo.Connect(this, [&](std::uint32_t aTick, std::uint32_t aTempo)
-		{
-			myTempos.emplace_back(aTick, ticksToTime(aTick), std::chrono::microseconds(aTempo));
-		}
-	);
+	// Notes are collected as they're decoded, then converted and paired in bulk once the track is done.
+	MidiDecoder::NoteBatch notes(arena->GetResource());
+	notes.ReserveForChunk(aChunk.size());
 
-	decoder.OnTimeSignature.Connect(this, [&](std::uint32_t aTick, std::uint8_t aNumerator, std::uint8_t aDenominator, std::uint8_t aClock, std::uint8_t aBase)
+	for (const MidiDecoder::Event& event : MidiDecoder::ReadTrackEvents(aChunk))
+	{
+		switch (event.Type)
 		{
-			myTimeSignatures.emplace_back(ticksToTime(aTick), TimeSignature{ aNumerator, aDenominator, aClock, aBase });
-		}
-	);
+		case MidiDecoder::EventType::Note:
+			notes.Add(event);
+			break;
 
-	decoder.OnText.Connect(this, [&](std::uint32_t, const std::string& aText)
-		{
-			if (aText.find("ENHANCED_OPENS") != std::string::npos)
-				currentTrackLoadData.EnhancedOpens = true;
+		case MidiDecoder::EventType::SysEx:
+			currentTrackLoadData.AddSysEx(ticksToTime(event.Tick), event.Payload);
+			break;
+
+		case MidiDecoder::EventType::Meta:
+			switch (event.Meta)
+			{
+			case MidiDecoder::MetaType::TrackName:
+				if (event.GetText().starts_with("PART "))
+				{
+					ZoneScopedN("Create track");
+					currentTrack = ChartTrack::CreateTrackByName(std::string(event.GetText().substr(5)));
+				}
+				break;
+
+			case MidiDecoder::MetaType::Text:
+				handleText(event.Tick, event.GetText());
+				break;
+
+			case MidiDecoder::MetaType::Lyric:
+				currentTrackLoadData.AddLyric(ticksToTime(event.Tick), event.GetText());
+				break;
+
+			case MidiDecoder::MetaType::TimeSignature:
+			{
+				TimeSignature timeSignature;
+				event.GetTimeSignature(timeSignature.Numerator, timeSignature.Denominator, timeSignature.Clock, timeSignature.Base);
+				outResult.TimeSignatures.emplace_back(event.Tick, timeSignature);
+				break;
+			}
+
+			case MidiDecoder::MetaType::EndOfTrack:
+				outResult.EndTick = event.Tick;
+
+				if (!currentTrack)
+					break;
+
+				{
+					std::pmr::vector<std::chrono::microseconds> noteTimes(notes.Size(), arena->GetResource());
+					myTempoMap.TicksToTimes(notes.Ticks, noteTimes);
+					currentTrackLoadData.AddNotes(notes.Ticks, noteTimes, notes.Notes, notes.Velocities);
+				}
+
+				if (currentTrack->Load(currentTrackLoadData))
+					outResult.Track = std::move(currentTrack);
+
+				currentTrack.reset();
+				break;
+
+			default:
+				break;
+			}
+			break;
+
+		default:
+			break;
 		}
-	);
+	}
 
-	decoder.ProcessFile(aMidi, formatType, ticksPerQuarterNote);
+	outResult.Memory = arena->GetStatistics();
 }
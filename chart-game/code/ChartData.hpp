@@ -1,13 +1,20 @@
 // Filter "Chart"
 #pragma once
 
+#include "ChartCache.hpp"
+#include "ChartLoadArena.hpp"
 #include "ChartTrack.hpp"
 #include "ChartCommonStructures.hpp"
+#include "TempoMap.hpp"
 
 #include <rose-common/fileformat/Ini.hpp>
 
+#include <atomic>
+#include <bitset>
 #include <filesystem>
 #include <map>
+#include <mutex>
+#include <span>
 
 namespace FileName_Audio
 {
@@ -63,6 +70,11 @@ public:
 public:
 	void Load(const std::filesystem::path& aSongIni);
 
+	// Only the parsed song info and difficulties are cached, not the whole ini.
+	void LoadCache(ChartCache::Reader& aReader);
+
+	void SaveCache(ChartCache::Writer& aWriter) const;
+
 	const SongInfo& GetSongInfo() const { return mySongInfo; }
 
 	const int GetDifficulty(ChartTrackType anInstrument) const { return myDifficulties.at(anInstrument); }
@@ -79,12 +91,9 @@ class ChartTrack;
 class ChartData
 {
 public:
-	struct TempoSection
-	{
-		std::uint32_t TickStart;
-		std::chrono::microseconds TimeStart;
-		std::chrono::microseconds TimePerBeat;
-	};
+	using TrackFilter = std::bitset<ChartTrackTypeCount>;
+
+	using TempoSection = TempoMap::Section;
 
 	struct TimeSignature
 	{
@@ -94,20 +103,71 @@ public:
 		std::uint8_t Base = 0;
 	};
 
+	// Shared with a load running on another thread, to follow its progress or stop it early.
+	class LoadStatus
+	{
+	public:
+		void Cancel() { myIsCancelled = true; }
+		bool IsCancelled() const { return myIsCancelled; }
+
+		float GetProgress() const { return myProgress; }
+		void SetProgress(float aProgress) { myProgress = aProgress; }
+
+		// The temporary memory the tracks used while decoding, set when a load from MIDI finishes.
+		// Stays empty when the chart came from a compiled chart.
+		ChartLoadArena::Statistics GetMemory() const
+		{
+			std::scoped_lock lock(myMutex);
+			return myMemory;
+		}
+
+		void SetMemory(const ChartLoadArena::Statistics& someMemory)
+		{
+			std::scoped_lock lock(myMutex);
+			myMemory = someMemory;
+		}
+
+	private:
+		std::atomic<float> myProgress = 0.f;
+		std::atomic<bool> myIsCancelled = false;
+
+		mutable std::mutex myMutex;
+		ChartLoadArena::Statistics myMemory;
+	};
+
+	struct Beat
+	{
+		std::chrono::microseconds Time = std::chrono::microseconds(0);
+		std::uint32_t Tick = 0;
+		std::uint32_t Index = 0;
+		std::uint32_t Measure = 0;
+		bool IsDownbeat = false;
+	};
+
 public:
 	std::chrono::microseconds GetBeatLengthAt(std::chrono::microseconds aTime) const;
 
 	float GetBeatsInPeriod(std::chrono::microseconds aFrom, std::chrono::microseconds aTo) const;
 
+	const std::vector<Beat>& GetBeats() const { return myBeats; }
+
+	// Beats from aFrom up to and including aTo.
+	std::span<const Beat> GetBeatsInRange(std::chrono::microseconds aFrom, std::chrono::microseconds aTo) const;
+
 	float GetBPMAt(std::chrono::microseconds aTime) const;
 
 	std::chrono::microseconds GetDuration() const;
 
+	// Identifies the files the chart was loaded from, so anything tied to this exact chart can tell when it changes.
+	std::uint64_t GetHash() const { return myHash; }
+
 	const std::string GetSectionNameAt(std::chrono::microseconds aTime) const;
 
 	const std::vector<std::pair<std::chrono::microseconds, std::string>>& GetSectionNames() const { return mySections; }
 
-	const std::vector<TempoSection>& GetTempoSections() const { return myTempos; }
+	const std::vector<TempoSection>& GetTempoSections() const { return myTempoMap.GetSections(); }
+
+	const TempoMap& GetTempoMap() const { return myTempoMap; }
 
 	const TimeSignature GetTimeSignatureAt(std::chrono::microseconds aTime) const;
 
@@ -115,11 +175,34 @@ public:
 
 	const std::map<ChartTrackType, std::unique_ptr<ChartTrack>>& GetTracks() const { return myTracks; }
 
-	void LoadMidi(const std::filesystem::path& aMidi);
+	// Loads the song's notes.mid, through a compiled chart when there's one made from the same notes.mid and song.ini.
+	// Compiled charts are written next to the song unless a cache directory is given.
+	// Returns false if the load was cancelled through aStatus, which leaves the chart incomplete.
+	bool Load(const std::filesystem::path& aSongIni, const std::filesystem::path& aCacheDirectory = {}, LoadStatus* aStatus = nullptr);
+
+	// Only decodes the instrument tracks in someTracks, along with the tempo and event tracks.
+	// Returns false if the load was cancelled through aStatus.
+	bool LoadMidi(const std::filesystem::path& aMidi, const TrackFilter& someTracks = TrackFilter().set(), LoadStatus* aStatus = nullptr);
 
 private:
+	struct TrackChunkResult;
+
+	void Clear();
+
+	void LoadCache(ChartCache::Reader& aReader);
+
+	void SaveCache(ChartCache::Writer& aWriter) const;
+
+	bool LoadMidiData(std::span<const std::uint8_t> someData, const TrackFilter& someTracks, LoadStatus* aStatus = nullptr);
+
+	void LoadTrackChunk(std::span<const std::uint8_t> aChunk, TrackChunkResult& outResult) const;
+
+	void BuildBeats(const std::vector<std::pair<std::uint32_t, TimeSignature>>& someTimeSignatures, std::uint32_t anEndTick);
+
 	std::map<ChartTrackType, std::unique_ptr<ChartTrack>> myTracks;
-	std::vector<TempoSection> myTempos;
+	TempoMap myTempoMap;
 	std::vector<std::pair<std::chrono::microseconds, TimeSignature>> myTimeSignatures;
 	std::vector<std::pair<std::chrono::microseconds, std::string>> mySections;
+	std::vector<Beat> myBeats;
+	std::uint64_t myHash = 0;
 };
@@ -1,37 +1,42 @@
 // Filter "Chart/Playback"
 #include "ChartHumanController.hpp"
 
-void ChartHumanController::HandleInput(const Atrium::InputEvent& anInputEvent)
+void ChartHumanController::HandleInput(const Atrium::InputEvent& anInputEvent, std::chrono::microseconds aTimepoint)
 {
 	using namespace Atrium;
 
+	const auto queueLane = [&](std::uint8_t aLane)
+	{
+		QueueInput({ aTimepoint, anInputEvent.Value > 0.5f ? TimedInput::Action::PressLane : TimedInput::Action::ReleaseLane, aLane });
+	};
+
 	switch (anInputEvent.Source)
 	{
 		case InputSourceId::Keyboard::Alpha1:
 		case InputSourceId::Keyboard::A:
-			SetLane(0, anInputEvent.Value > 0.5f);
+			queueLane(0);
 			break;
 		case InputSourceId::Keyboard::Alpha2:
 		case InputSourceId::Keyboard::S:
-			SetLane(1, anInputEvent.Value > 0.5f);
+			queueLane(1);
 			break;
 		case InputSourceId::Keyboard::Alpha3:
 		case InputSourceId::Keyboard::D:
 		case InputSourceId::Keyboard::J:
-			SetLane(2, anInputEvent.Value > 0.5f);
+			queueLane(2);
 			break;
 		case InputSourceId::Keyboard::Alpha4:
 		case InputSourceId::Keyboard::K:
-			SetLane(3, anInputEvent.Value > 0.5f);
+			queueLane(3);
 			break;
 		case InputSourceId::Keyboard::Alpha5:
 		case InputSourceId::Keyboard::L:
-			SetLane(4, anInputEvent.Value > 0.5f);
+			queueLane(4);
 			break;
 
 		case InputSourceId::Keyboard::Spacebar:
 			if (anInputEvent.Type == InputEventType::Pressed)
-				Strum();
+				QueueInput({ aTimepoint, TimedInput::Action::Strum });
 			break;
 	}
 }
\ No newline at end of file
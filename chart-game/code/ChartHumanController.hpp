@@ -8,5 +8,7 @@ class ChartHumanController : public ChartController
 public:
 	virtual const char* GetName() const override { return "Human player"; }
 
-	void HandleInput(const Atrium::InputEvent& anInputEvent);
+	const char* GetInputDevice() const override { return "Keyboard"; }
+
+	void HandleInput(const Atrium::InputEvent& anInputEvent, std::chrono::microseconds aTimepoint) override;
 };
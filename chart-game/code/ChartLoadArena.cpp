@@ -0,0 +1,105 @@
+// Filter "Chart"
+#include "ChartLoadArena.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace ChartLoadArenaPool
+{
+	static std::mutex Mutex;
+	static std::vector<std::unique_ptr<ChartLoadArena>> FreeArenas;
+}
+
+ChartLoadArena::Statistics& ChartLoadArena::Statistics::operator+=(const Statistics& someOther)
+{
+	AllocationCount += someOther.AllocationCount;
+	HeapAllocationCount += someOther.HeapAllocationCount;
+	PeakBytes += someOther.PeakBytes;
+	return *this;
+}
+
+void ChartLoadArena::Releaser::operator()(ChartLoadArena* anArena) const
+{
+	anArena->Reset();
+
+	std::scoped_lock lock(ChartLoadArenaPool::Mutex);
+	ChartLoadArenaPool::FreeArenas.emplace_back(anArena);
+}
+
+ChartLoadArena::Handle ChartLoadArena::Acquire()
+{
+	{
+		std::scoped_lock lock(ChartLoadArenaPool::Mutex);
+		if (!ChartLoadArenaPool::FreeArenas.empty())
+		{
+			Handle arena(ChartLoadArenaPool::FreeArenas.back().release());
+			ChartLoadArenaPool::FreeArenas.pop_back();
+			return arena;
+		}
+	}
+
+	return Handle(new ChartLoadArena());
+}
+
+ChartLoadArena::Statistics ChartLoadArena::GetStatistics() const
+{
+	Statistics statistics;
+	statistics.AllocationCount = myCounter.GetAllocationCount();
+	statistics.HeapAllocationCount = myHeap.GetAllocationCount();
+	statistics.PeakBytes = myCounter.GetPeakBytes();
+	return statistics;
+}
+
+ChartLoadArena::ChartLoadArena()
+	: myHeap(std::pmr::new_delete_resource())
+	, myArena(std::in_place, &myHeap)
+	, myCounter(&*myArena)
+{
+}
+
+void ChartLoadArena::Reset()
+{
+	const std::size_t requiredSize = myBufferSize + myHeap.GetAllocatedBytes();
+
+	myArena->release();
+
+	if (requiredSize > myBufferSize)
+	{
+		myArena.reset();
+		myBuffer.reset();
+
+		myBufferSize = requiredSize;
+		myBuffer = std::make_unique_for_overwrite<std::byte[]>(myBufferSize);
+		myArena.emplace(myBuffer.get(), myBufferSize, &myHeap);
+	}
+
+	myHeap.ResetCounts();
+	myCounter.ResetCounts();
+}
+
+void ChartLoadArena::CountingResource::ResetCounts()
+{
+	myAllocationCount = 0;
+	myAllocatedBytes = 0;
+	myCurrentBytes = 0;
+	myPeakBytes = 0;
+}
+
+void* ChartLoadArena::CountingResource::do_allocate(std::size_t aSize, std::size_t anAlignment)
+{
+	void* pointer = myUpstream->allocate(aSize, anAlignment);
+
+	++myAllocationCount;
+	myAllocatedBytes += aSize;
+	myCurrentBytes += aSize;
+	myPeakBytes = std::max(myPeakBytes, myCurrentBytes);
+
+	return pointer;
+}
+
+void ChartLoadArena::CountingResource::do_deallocate(void* aPointer, std::size_t aSize, std::size_t anAlignment)
+{
+	myUpstream->deallocate(aPointer, aSize, anAlignment);
+	myCurrentBytes -= aSize;
+}
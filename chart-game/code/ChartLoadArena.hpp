@@ -0,0 +1,78 @@
+// Filter "Chart"
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Memory for the data that only lives while a track is being loaded, like staged notes and SysEx payloads.
+// Everything is released at once when the arena goes back to its pool, and the arena keeps enough memory
+// to serve the same amount again without going to the heap.
+class ChartLoadArena
+{
+public:
+	struct Statistics
+	{
+		std::size_t AllocationCount = 0;
+		std::size_t HeapAllocationCount = 0;
+		std::size_t PeakBytes = 0;
+
+		Statistics& operator+=(const Statistics& someOther);
+	};
+
+	struct Releaser
+	{
+		void operator()(ChartLoadArena* anArena) const;
+	};
+
+	using Handle = std::unique_ptr<ChartLoadArena, Releaser>;
+
+	// Takes an unused arena from the shared pool, or creates one if they're all in use.
+	static Handle Acquire();
+
+public:
+	ChartLoadArena(const ChartLoadArena&) = delete;
+	ChartLoadArena& operator=(const ChartLoadArena&) = delete;
+
+	std::pmr::memory_resource* GetResource() { return &myCounter; }
+
+	// Counts since the arena was acquired.
+	Statistics GetStatistics() const;
+
+private:
+	// Passes allocations on to another resource and keeps count of them.
+	class CountingResource : public std::pmr::memory_resource
+	{
+	public:
+		explicit CountingResource(std::pmr::memory_resource* anUpstream) : myUpstream(anUpstream) { }
+
+		void ResetCounts();
+
+		std::size_t GetAllocationCount() const { return myAllocationCount; }
+		std::size_t GetAllocatedBytes() const { return myAllocatedBytes; }
+		std::size_t GetPeakBytes() const { return myPeakBytes; }
+
+	private:
+		void* do_allocate(std::size_t aSize, std::size_t anAlignment) override;
+		void do_deallocate(void* aPointer, std::size_t aSize, std::size_t anAlignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& anOther) const noexcept override { return this == &anOther; }
+
+		std::pmr::memory_resource* myUpstream;
+		std::size_t myAllocationCount = 0;
+		std::size_t myAllocatedBytes = 0;
+		std::size_t myCurrentBytes = 0;
+		std::size_t myPeakBytes = 0;
+	};
+
+	ChartLoadArena();
+
+	// Frees everything allocated so far. Anything that had to come from the heap is folded into the arena's own buffer for next time.
+	void Reset();
+
+	CountingResource myHeap;
+	std::unique_ptr<std::byte[]> myBuffer;
+	std::size_t myBufferSize = 0;
+	std::optional<std::pmr::monotonic_buffer_resource> myArena;
+	CountingResource myCounter;
+};
@@ -3,6 +3,17 @@
 
 #include "ChartData.hpp"
 #include "Atrium_Diagnostics.hpp"
+#include "Atrium_Math.hpp"
+
+ChartPlayer::~ChartPlayer()
+{
+	// The futures of async loads block in their destructors until the load is done.
+	if (myPendingLoad)
+		myPendingLoad->Status->Cancel();
+
+	for (PendingLoad& load : myCancelledLoads)
+		load.Status->Cancel();
+}
 
 ChartPlayer::State ChartPlayer::GetState() const
 {
@@ -22,18 +33,55 @@ ChartPlayer::State ChartPlayer::GetState() const
 	return State::Stopped;
 }
 
-void ChartPlayer::LoadChart(const std::filesystem::path& aSong)
+std::chrono::microseconds ChartPlayer::GetPlayheadAt(std::chrono::high_resolution_clock::time_point aTime) const
 {
-	myActiveChart = ActiveChart();
-	ActiveChart& activeChart = myActiveChart.value();
+	if (myState != InternalState::Playing)
+		return myPlayhead;
 
-	activeChart.Info.Load(aSong);
-	activeChart.Data.LoadMidi(aSong.parent_path() / "notes.mid");
+	// Never before the playhead, so inputs don't land in a step the controllers have already been through.
+	return Atrium::Math::Max(myPlayhead, std::chrono::duration_cast<std::chrono::microseconds>(aTime - myStartTime));
+}
 
-	// Todo: Set up all audio clips.
+void ChartPlayer::HandleInput(const Atrium::InputEvent& anInputEvent)
+{
+	const std::chrono::microseconds timepoint = GetPlayheadAt(std::chrono::high_resolution_clock::now());
 
 	for (const std::unique_ptr<ChartController>& controller : myControllers)
-		controller->HandleChartChange(myActiveChart.value().Data);
+		controller->HandleInput(anInputEvent, timepoint);
+}
+
+void ChartPlayer::LoadChart(const std::filesystem::path& aSong)
+{
+	std::unique_ptr<ActiveChart> chart = std::make_unique<ActiveChart>();
+	chart->Info.Load(aSong);
+	chart->Data.Load(aSong);
+
+	SetActiveChart(std::move(chart));
+}
+
+std::shared_ptr<ChartData::LoadStatus> ChartPlayer::LoadChartAsync(const std::filesystem::path& aSong)
+{
+	if (myPendingLoad)
+	{
+		myPendingLoad->Status->Cancel();
+		myCancelledLoads.push_back(std::move(myPendingLoad.value()));
+		myPendingLoad.reset();
+	}
+
+	PendingLoad& load = myPendingLoad.emplace();
+	load.Status = std::make_shared<ChartData::LoadStatus>();
+	load.Result = std::async(std::launch::async, [aSong, status = load.Status]() -> std::unique_ptr<ActiveChart>
+		{
+			std::unique_ptr<ActiveChart> chart = std::make_unique<ActiveChart>();
+			chart->Info.Load(aSong);
+			if (!chart->Data.Load(aSong, { }, status.get()))
+				return nullptr;
+
+			return chart;
+		}
+	);
+
+	return load.Status;
 }
 
 void ChartPlayer::Pause()
@@ -107,6 +155,8 @@ void ChartPlayer::Stop()
 
 void ChartPlayer::Update()
 {
+	UpdatePendingLoads();
+
 	const auto newUpdateTime = std::chrono::high_resolution_clock::now();
 	const auto lastUpdatePoint = std::chrono::duration_cast<std::chrono::microseconds>(myLastUpdateTime - myStartTime);
 	const auto thisUpdatePoint = std::chrono::duration_cast<std::chrono::microseconds>(newUpdateTime - myStartTime);
@@ -122,6 +172,8 @@ void ChartPlayer::Update()
 		break;
 	case InternalState::Paused:
 		myStartTime += (thisUpdatePoint - lastUpdatePoint);
+		for (const std::unique_ptr<ChartController>& controller : myControllers)
+			controller->HandleQueuedInputs(myPlayhead);
 		break;
 	case InternalState::SeekingPlaying:
 	case InternalState::SeekingPaused:
@@ -129,6 +181,44 @@ void ChartPlayer::Update()
 		myState = (myState == InternalState::SeekingPlaying ? InternalState::Playing : InternalState::Paused);
 		break;
 	case InternalState::Stopped:
+		for (const std::unique_ptr<ChartController>& controller : myControllers)
+			controller->HandleQueuedInputs(myPlayhead);
 		break;
 	}
 }
+
+void ChartPlayer::SetActiveChart(std::unique_ptr<ActiveChart> aChart)
+{
+	myActiveChart = std::move(*aChart);
+
+	// Todo: Set up all audio clips.
+
+	for (const std::unique_ptr<ChartController>& controller : myControllers)
+		controller->HandleChartChange(myActiveChart.value().Data);
+}
+
+void ChartPlayer::UpdatePendingLoads()
+{
+	const auto isReady = [](const PendingLoad& aLoad) { return aLoad.Result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+
+	std::erase_if(myCancelledLoads, isReady);
+
+	if (!myPendingLoad || !isReady(myPendingLoad.value()))
+		return;
+
+	std::future<std::unique_ptr<ActiveChart>> result = std::move(myPendingLoad->Result);
+	myPendingLoad.reset();
+
+	std::unique_ptr<ActiveChart> chart;
+	try
+	{
+		chart = result.get();
+	}
+	catch (const std::exception& anException)
+	{
+		Atrium::Debug::LogError("Couldn't load chart: %s", anException.what());
+	}
+
+	if (chart)
+		SetActiveChart(std::move(chart));
+}
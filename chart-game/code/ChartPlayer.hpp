@@ -1,12 +1,14 @@
 // Filter "Chart/Playback"
 #pragma once
 
+#include "ChartCalibration.hpp"
 #include "ChartController.hpp"
 #include "ChartData.hpp"
 
 #include <array>
 #include <chrono>
 #include <filesystem>
+#include <future>
 #include <memory>
 #include <vector>
 
@@ -16,19 +18,40 @@ public:
 	enum class State { Playing, Paused, Seeking, Stopped };
 
 public:
+	// Cancels any loads still running, so destroying the player only waits for them to notice rather than to finish.
+	~ChartPlayer();
+
 	template <typename T>
 	T* AddController();
 
+	ChartCalibration& GetCalibration() { return myCalibration; }
+	const ChartCalibration& GetCalibration() const { return myCalibration; }
+
 	const ChartData* GetChartData() { return myActiveChart.transform([](ActiveChart& chart) { return &chart.Data; }).value_or(nullptr); }
 
 	const std::vector<std::unique_ptr<ChartController>>& GetControllers() const { return myControllers; }
 
 	std::chrono::microseconds GetPlayhead() const { return myPlayhead; }
 
+	// The point in the chart that was playing at aTime, which can be between updates.
+	std::chrono::microseconds GetPlayheadAt(std::chrono::high_resolution_clock::time_point aTime) const;
+
 	State GetState() const;
 
+	// Passes anInputEvent on to the controllers, stamped with the point in the chart it happened at.
+	// Call this as soon as the event comes in, as that's the time it's judged at.
+	// Events carry no time of their own, so the stamp is when this is called. If events are only pumped once per frame,
+	// every event in a frame gets that frame's time, and judging is still only as exact as the frame rate.
+	void HandleInput(const Atrium::InputEvent& anInputEvent);
+
+	bool IsLoading() const { return myPendingLoad.has_value(); }
+
 	void LoadChart(const std::filesystem::path& aSong);
 
+	// Loads the chart on a background thread. It replaces the active chart at the start of the first Update after it finishes.
+	// Starting another load cancels this one.
+	std::shared_ptr<ChartData::LoadStatus> LoadChartAsync(const std::filesystem::path& aSong);
+
 	void Pause();
 
 	void Play();
@@ -53,7 +76,18 @@ private:
 		ChartData Data;
 	};
 
+	struct PendingLoad
+	{
+		std::shared_ptr<ChartData::LoadStatus> Status;
+		std::future<std::unique_ptr<ActiveChart>> Result;
+	};
+
+	void SetActiveChart(std::unique_ptr<ActiveChart> aChart);
+	void UpdatePendingLoads();
+
 	std::optional<ActiveChart> myActiveChart;
+	std::optional<PendingLoad> myPendingLoad;
+	std::vector<PendingLoad> myCancelledLoads;
 
 	InternalState myState = InternalState::Stopped;
 	std::chrono::high_resolution_clock::time_point myStartTime;
@@ -61,6 +95,8 @@ private:
 
 	std::chrono::microseconds myPlayhead{ 0 };
 
+	ChartCalibration myCalibration;
+
 	std::vector<std::unique_ptr<ChartController>> myControllers;
 };
 
@@ -68,6 +104,7 @@ template<typename T>
 inline T* ChartPlayer::AddController()
 {
 	std::unique_ptr<ChartController>& newController = myControllers.emplace_back(std::make_unique<T>());
+	newController->SetCalibration(myCalibration);
 	if (myActiveChart)
 		newController->HandleChartChange(myActiveChart.value().Data);
 	return static_cast<T*>(newController.get());
@@ -202,13 +202,24 @@ void ChartRenderer::RenderController(ChartController& aController)
 
 void ChartRenderer::RenderNotes(ChartController& aController, const ChartGuitarTrack& aTrack)
 {
-	const std::vector<ChartNoteRange>& difficultyNotes = aTrack.GetNoteRanges().at(aController.GetTrackDifficulty());
+	// Only the notes that can reach the visible part of the fretboard.
+	const std::span<const ChartNoteRange> difficultyNotes = aTrack.GetNoteSpanInRange(
+		aController.GetTrackDifficulty(),
+		PositionOffsetToTime(-FretboardMatrices::TargetOffset - Atrium::Math::Max(NotePositionAdjustment, SustainPositionAdjustment)),
+		PositionOffsetToTime(FretboardLength - FretboardMatrices::TargetOffset - Atrium::Math::Min(NotePositionAdjustment, SustainPositionAdjustment))
+	);
+
 	for (const ChartNoteRange& note : difficultyNotes)
 	{
 		if (!note.IsSustain())
 			continue;
 
-		const std::optional<std::chrono::microseconds> sustainHitEnd = aController.GetNoteHitEnd(note);
+		const bool isSustainActive = aController.IsSustainActive(note);
+		std::optional<std::chrono::microseconds> sustainHitEnd = aController.GetNoteHitEnd(note);
+
+		// Judging trails behind by the input offset, but held sustains should still look like they're being played at the target.
+		if (isSustainActive)
+			sustainHitEnd = Atrium::Math::Min(GetVisualPlayhead(), note.End);
 
 		if (note.CanBeOpen && aController.AllowOpenNotes())
 		{
@@ -217,7 +228,7 @@ void ChartRenderer::RenderNotes(ChartController& aController, const ChartGuitarT
 		else
 		{
 			SustainState state = SustainState::Neutral;
-			if (aController.IsSustainActive(note))
+			if (isSustainActive)
 				state = SustainState::Active;
 			else if (aController.IsNoteMissed(note))
 				state = SustainState::Missed;
@@ -226,7 +237,7 @@ void ChartRenderer::RenderNotes(ChartController& aController, const ChartGuitarT
 		}
 	}
 
-	for (auto note = difficultyNotes.crbegin(); note != difficultyNotes.crend(); ++note)
+	for (auto note = difficultyNotes.rbegin(); note != difficultyNotes.rend(); ++note)
 	{
 		if (aController.GetNoteHitEnd(*note).has_value())
 			continue;
@@ -442,7 +453,7 @@ void ChartRenderer::QueueTargets(ChartController& aController)
 
 float ChartRenderer::TimeToPositionOffset(std::chrono::microseconds aTime) const
 {
-	const auto relativeToPlayhead = aTime - myPlayer.GetPlayhead();
+	const auto relativeToPlayhead = aTime - GetVisualPlayhead();
 	const float playheadToLookahead = static_cast<float>(relativeToPlayhead.count()) / static_cast<float>(LookAhead.count());
 
 	return Atrium::Math::Lerp(
@@ -450,3 +461,15 @@ float ChartRenderer::TimeToPositionOffset(std::chrono::microseconds aTime) const
 		FretboardLength - FretboardMatrices::TargetOffset,
 		playheadToLookahead);
 }
+
+std::chrono::microseconds ChartRenderer::PositionOffsetToTime(float aPosition) const
+{
+	const float playheadToLookahead = aPosition / (FretboardLength - FretboardMatrices::TargetOffset);
+	return GetVisualPlayhead() + std::chrono::microseconds(static_cast<std::int64_t>(playheadToLookahead * static_cast<float>(LookAhead.count())));
+}
+
+std::chrono::microseconds ChartRenderer::GetVisualPlayhead() const
+{
+	// What's on screen now is only seen a little later, so show what will be playing by then.
+	return myPlayer.GetPlayhead() + myPlayer.GetCalibration().GetAudioVideoOffset();
+}
@@ -47,6 +47,10 @@ private:
 	void QueueTargets(ChartController& aController);
 
 	float TimeToPositionOffset(std::chrono::microseconds aTime) const;
+	std::chrono::microseconds PositionOffsetToTime(float aPosition) const;
+
+	// The playhead adjusted by the audio/video offset, which the notes are drawn around.
+	std::chrono::microseconds GetVisualPlayhead() const;
 
 	ChartPlayer& myPlayer;
 
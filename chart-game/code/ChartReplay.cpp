@@ -0,0 +1,302 @@
+// Filter "Chart/Playback"
+#include "ChartReplay.hpp"
+
+#include "ChartCache.hpp"
+#include "ChartData.hpp"
+#include "ChartScoring.hpp"
+
+#include "Atrium_Diagnostics.hpp"
+
+#include <stdexcept>
+
+// "RPLY" when read as bytes.
+static constexpr std::uint32_t ReplayMagic = 0x594C5052;
+
+// Judges a recording with the same settings as the controller that made it.
+class ChartReplayController : public ChartController
+{
+public:
+	explicit ChartReplayController(const std::string& anInputDevice) : myInputDevice(anInputDevice) { }
+
+	const char* GetName() const override { return "Replay"; }
+
+	const char* GetInputDevice() const override { return myInputDevice.empty() ? nullptr : myInputDevice.c_str(); }
+
+private:
+	std::string myInputDevice;
+};
+
+// Times are stored as the difference from the previous one, which is small and mostly positive,
+// so they're zigzag encoded to keep negative differences small too, then written 7 bits at a time.
+static void WriteVarint(std::vector<std::uint8_t>& someBytes, std::int64_t aValue)
+{
+	std::uint64_t value = (static_cast<std::uint64_t>(aValue) << 1) ^ static_cast<std::uint64_t>(aValue >> 63);
+	while (value >= 0x80)
+	{
+		someBytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	someBytes.push_back(static_cast<std::uint8_t>(value));
+}
+
+static std::int64_t ReadVarint(std::span<const std::uint8_t> someBytes, std::size_t& aPosition)
+{
+	std::uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (aPosition >= someBytes.size())
+			throw std::runtime_error("Replay data ends in the middle of a value.");
+
+		const std::uint8_t byte = someBytes[aPosition++];
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0)
+			return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+	}
+
+	throw std::runtime_error("Replay data has a value that's too long.");
+}
+
+ChartReplay::Result ChartReplay::GetResult(const ChartScoring& aScoring)
+{
+	Result result;
+	result.Score = aScoring.GetScore();
+	result.HitCount = aScoring.GetHitCount();
+	result.NoteCount = aScoring.GetNoteCount();
+	result.MaximumStreak = aScoring.GetMaximumStreak();
+	return result;
+}
+
+ChartReplay::ChartReplay(const ChartData& aChart)
+	: myChartHash(aChart.GetHash())
+{
+}
+
+void ChartReplay::AddController(const ChartController& aController)
+{
+	ControllerReplay& replay = myControllers.emplace_back();
+
+	if (const char* device = aController.GetInputDevice())
+		replay.InputDevice = device;
+
+	replay.TrackType = aController.GetTrackType();
+	replay.TrackDifficulty = aController.GetTrackDifficulty();
+	replay.HitWindow = aController.GetCalibration().GetHitWindow();
+	replay.InputOffset = aController.GetCalibration().GetInputOffset(replay.InputDevice);
+	replay.Recording = aController.GetInputRecording();
+	replay.RecordedResult = GetResult(aController.GetScoring());
+}
+
+std::vector<ChartReplay::Result> ChartReplay::Play(const ChartData& aChart) const
+{
+	ZoneScoped;
+
+	if (aChart.GetHash() != myChartHash)
+		throw std::runtime_error("The replay was recorded on a different chart.");
+
+	std::vector<Result> results;
+	results.reserve(myControllers.size());
+
+	for (const ControllerReplay& replay : myControllers)
+	{
+		ChartCalibration calibration;
+		calibration.SetHitWindow(replay.HitWindow);
+		if (!replay.InputDevice.empty())
+			calibration.SetInputOffset(replay.InputDevice, replay.InputOffset);
+
+		ChartReplayController controller(replay.InputDevice);
+		controller.SetCalibration(calibration);
+		controller.SetTrackType(replay.TrackType);
+		controller.SetTrackDifficulty(replay.TrackDifficulty);
+		controller.HandleChartChange(aChart);
+
+		const std::span<const std::pair<std::chrono::microseconds, std::chrono::microseconds>> steps = replay.Recording.Steps;
+		if (!steps.empty())
+		{
+			// The first step is where the recording started over, which would throw away anything queued before it.
+			controller.HandlePlayheadStep(steps.front().first, steps.front().second);
+
+			// Inputs are only judged once a step reaches them, so they can all be queued up front.
+			for (const ChartController::TimedInput& input : replay.Recording.Inputs)
+				controller.QueueInput(input);
+
+			for (const auto& [previous, next] : steps.subspan(1))
+				controller.HandlePlayheadStep(previous, next);
+		}
+
+		results.push_back(GetResult(controller.GetScoring()));
+	}
+
+	return results;
+}
+
+bool ChartReplay::Verify(const ChartData& aChart) const
+{
+	ZoneScoped;
+
+	std::vector<Result> results;
+	try
+	{
+		results = Play(aChart);
+	}
+	catch (const std::exception& anException)
+	{
+		Atrium::Debug::LogWarning("Couldn't play replay: %s", anException.what());
+		return false;
+	}
+
+	bool isMatching = true;
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		const Result& recorded = myControllers[i].RecordedResult;
+		if (results[i] == recorded)
+			continue;
+
+		Atrium::Debug::LogWarning(
+			"Replay of controller %zu doesn't match: score %u (recorded %u), hits %u / %u (recorded %u / %u), maximum streak %u (recorded %u).",
+			i + 1,
+			results[i].Score, recorded.Score,
+			results[i].HitCount, results[i].NoteCount, recorded.HitCount, recorded.NoteCount,
+			results[i].MaximumStreak, recorded.MaximumStreak
+		);
+		isMatching = false;
+	}
+
+	return isMatching;
+}
+
+bool ChartReplay::Load(const std::filesystem::path& aPath)
+{
+	ZoneScoped;
+
+	const std::vector<std::uint8_t> data = ChartCache::ReadFile(aPath);
+	if (data.empty())
+		return false;
+
+	try
+	{
+		ChartCache::Reader reader(data);
+		if (!reader.ReadHeader(ChartCache::FileHeader { ReplayMagic, FileVersion }))
+			return false;
+
+		std::uint64_t chartHash = 0;
+		reader.Read(chartHash);
+
+		std::uint32_t controllerCount = 0;
+		reader.Read(controllerCount);
+
+		std::vector<ControllerReplay> controllers(controllerCount);
+		std::vector<std::uint8_t> bytes;
+		for (ControllerReplay& replay : controllers)
+		{
+			std::uint8_t trackType = 0;
+			std::uint8_t trackDifficulty = 0;
+			std::int64_t hitWindow = 0;
+			std::int64_t inputOffset = 0;
+
+			reader.ReadString(replay.InputDevice);
+			reader.Read(trackType);
+			reader.Read(trackDifficulty);
+			reader.Read(hitWindow);
+			reader.Read(inputOffset);
+			reader.Read(replay.RecordedResult);
+
+			if (trackType >= ChartTrackTypeCount || trackDifficulty >= ChartTrackDifficultyCount)
+				throw std::runtime_error("Replay has an unknown track.");
+
+			replay.TrackType = static_cast<ChartTrackType>(trackType);
+			replay.TrackDifficulty = static_cast<ChartTrackDifficulty>(trackDifficulty);
+			replay.HitWindow = std::chrono::microseconds(hitWindow);
+			replay.InputOffset = std::chrono::microseconds(inputOffset);
+
+			reader.ReadArray(bytes);
+			std::chrono::microseconds lastTime(0);
+			for (std::size_t position = 0; position < bytes.size();)
+			{
+				const std::chrono::microseconds previous = lastTime + std::chrono::microseconds(ReadVarint(bytes, position));
+				lastTime = previous + std::chrono::microseconds(ReadVarint(bytes, position));
+				replay.Recording.Steps.emplace_back(previous, lastTime);
+			}
+
+			reader.ReadArray(bytes);
+			lastTime = std::chrono::microseconds(0);
+			for (std::size_t position = 0; position < bytes.size();)
+			{
+				ChartController::TimedInput& input = replay.Recording.Inputs.emplace_back();
+				lastTime += std::chrono::microseconds(ReadVarint(bytes, position));
+				input.Time = lastTime;
+
+				if (position >= bytes.size())
+					throw std::runtime_error("Replay data ends in the middle of an input.");
+
+				const std::uint8_t action = bytes[position++];
+				if ((action & 0x3) > static_cast<std::uint8_t>(ChartController::TimedInput::Action::Strum))
+					throw std::runtime_error("Replay has an unknown input.");
+
+				input.Type = static_cast<ChartController::TimedInput::Action>(action & 0x3);
+				input.Lane = static_cast<std::uint8_t>(action >> 2);
+			}
+		}
+
+		myChartHash = chartHash;
+		myControllers = std::move(controllers);
+	}
+	catch (const std::exception& anException)
+	{
+		Atrium::Debug::LogWarning("Couldn't load replay from %s: %s", aPath.string().c_str(), anException.what());
+		return false;
+	}
+
+	return true;
+}
+
+bool ChartReplay::Save(const std::filesystem::path& aPath) const
+{
+	ZoneScoped;
+
+	ChartCache::Writer writer(ChartCache::FileHeader { ReplayMagic, FileVersion });
+
+	writer.Write(myChartHash);
+	writer.Write(static_cast<std::uint32_t>(myControllers.size()));
+
+	std::vector<std::uint8_t> bytes;
+	for (const ControllerReplay& replay : myControllers)
+	{
+		writer.WriteString(replay.InputDevice);
+		writer.Write(static_cast<std::uint8_t>(replay.TrackType));
+		writer.Write(static_cast<std::uint8_t>(replay.TrackDifficulty));
+		writer.Write(static_cast<std::int64_t>(replay.HitWindow.count()));
+		writer.Write(static_cast<std::int64_t>(replay.InputOffset.count()));
+		writer.Write(replay.RecordedResult);
+
+		// Steps usually start where the last one ended, so most of them only take a few bytes.
+		bytes.clear();
+		std::chrono::microseconds lastTime(0);
+		for (const auto& [previous, next] : replay.Recording.Steps)
+		{
+			WriteVarint(bytes, (previous - lastTime).count());
+			WriteVarint(bytes, (next - previous).count());
+			lastTime = next;
+		}
+		writer.WriteArray(std::span<const std::uint8_t>(bytes));
+
+		// The action and lane share a byte.
+		bytes.clear();
+		lastTime = std::chrono::microseconds(0);
+		for (const ChartController::TimedInput& input : replay.Recording.Inputs)
+		{
+			WriteVarint(bytes, (input.Time - lastTime).count());
+			bytes.push_back(static_cast<std::uint8_t>(static_cast<std::uint8_t>(input.Type) | (input.Lane << 2)));
+			lastTime = input.Time;
+		}
+		writer.WriteArray(std::span<const std::uint8_t>(bytes));
+	}
+
+	if (!writer.SaveToFile(aPath))
+	{
+		Atrium::Debug::LogWarning("Couldn't write replay to %s", aPath.string().c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,72 @@
+// Filter "Chart/Playback"
+#pragma once
+
+#include "ChartController.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class ChartData;
+class ChartScoring;
+
+// A recorded play session: what each controller played, with the settings it was judged with and the results it got.
+// Playing it back judges the same inputs again with fresh controllers, without rendering or waiting for real time.
+class ChartReplay
+{
+public:
+	// Bump whenever the layout of replay files changes.
+	static constexpr std::uint32_t FileVersion = 2;
+
+	struct Result
+	{
+		unsigned int Score = 0;
+		unsigned int HitCount = 0;
+		unsigned int NoteCount = 0;
+		unsigned int MaximumStreak = 0;
+
+		bool operator==(const Result& anOther) const = default;
+	};
+
+	struct ControllerReplay
+	{
+		std::string InputDevice;
+		ChartTrackType TrackType = ChartTrackType::LeadGuitar;
+		ChartTrackDifficulty TrackDifficulty = ChartTrackDifficulty::Hard;
+		std::chrono::microseconds HitWindow;
+		std::chrono::microseconds InputOffset;
+
+		ChartController::InputRecording Recording;
+		Result RecordedResult;
+	};
+
+	static Result GetResult(const ChartScoring& aScoring);
+
+	static std::filesystem::path GetDefaultPath() { return "replay.bin"; }
+
+public:
+	ChartReplay() = default;
+	explicit ChartReplay(const ChartData& aChart);
+
+	// Adds what aController has recorded so far, along with its current settings and results.
+	void AddController(const ChartController& aController);
+
+	std::uint64_t GetChartHash() const { return myChartHash; }
+	const std::vector<ControllerReplay>& GetControllers() const { return myControllers; }
+
+	// Judges every controller's recording again on aChart, which has to be the chart that was recorded.
+	// Returns the results in the same order as the controllers.
+	std::vector<Result> Play(const ChartData& aChart) const;
+
+	// Plays the replay and checks that every controller gets the results that were recorded.
+	bool Verify(const ChartData& aChart) const;
+
+	bool Load(const std::filesystem::path& aPath);
+	bool Save(const std::filesystem::path& aPath) const;
+
+private:
+	std::uint64_t myChartHash = 0;
+	std::vector<ControllerReplay> myControllers;
+};
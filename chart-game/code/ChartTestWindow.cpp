@@ -6,6 +6,7 @@
 #include "ChartHumanController.hpp"
 #include "ChartPlayer.hpp"
 #include "ChartRenderer.hpp"
+#include "ChartReplay.hpp"
 #include "ChartTrack.hpp"
 
 #include "Atrium_Diagnostics.hpp"
@@ -75,6 +76,12 @@ void ChartTestWindow::ImGui()
 				ImGui::EndTabItem();
 			}
 
+			if (ImGui::BeginTabItem("Calibration"))
+			{
+				ImGui_Calibration();
+				ImGui::EndTabItem();
+			}
+
 			if (ImGui::BeginTabItem("Songs"))
 			{
 				ImGui_ChartList();
@@ -217,6 +224,10 @@ void ChartTestWindow::ImGui_DrawChart(Atrium::Vector2 aSize, std::function<void(
 			const float playheadToLookahead = static_cast<float>(relativeToPlayhead.count()) / static_cast<float>(myLookAhead.count());
 			return std::lerp(HIT_WINDOW_OFFSET, canvasSize.X, playheadToLookahead);
 		};
+		params.PointToTime = [&](float aPoint) -> std::chrono::microseconds {
+			const float playheadToLookahead = (aPoint - HIT_WINDOW_OFFSET) / (canvasSize.X - HIT_WINDOW_OFFSET);
+			return myChartPlayer.GetPlayhead() + std::chrono::microseconds(static_cast<std::int64_t>(playheadToLookahead * static_cast<float>(myLookAhead.count())));
+		};
 
 		ImGui_DrawChart_Beats(params);
 		aDrawFunction(params);
@@ -327,6 +338,9 @@ void ChartTestWindow::ImGui_ChartList()
 {
 	ZoneScoped;
 
+	if (mySongLibrary.UpdateScan())
+		mySongLibrary.SaveIndex();
+
 	ImGui_ChartList_Path();
 
 	if (ImGui::BeginTable("Song table", 3))
@@ -336,12 +350,12 @@ void ChartTestWindow::ImGui_ChartList()
 		ImGui::TableSetupColumn("Actions");
 		ImGui::TableHeadersRow();
 
-		for (const auto& it : myChartInfos)
+		for (const auto& it : mySongLibrary.GetSongs())
 		{
 			ImGui::TableNextRow();
 			ImGui::PushID(it.first.c_str());
 
-			const ChartInfo::SongInfo& songInfo = it.second->GetSongInfo();
+			const ChartInfo::SongInfo& songInfo = it.second.Info.GetSongInfo();
 
 			ImGui::TableNextColumn();
 			ImGui::TextUnformatted(songInfo.Title.c_str());
@@ -353,7 +367,7 @@ void ChartTestWindow::ImGui_ChartList()
 
 			auto difficultyWidget = [&](ChartTrackType aTrack, const char* aTitle)
 				{
-					const int difficulty = it.second->GetDifficulty(aTrack);
+					const int difficulty = it.second.Info.GetDifficulty(aTrack);
 					if (difficulty == -1)
 						return;
 
@@ -371,8 +385,17 @@ void ChartTestWindow::ImGui_ChartList()
 
 			ImGui::TableNextColumn();
 
-			if (ImGui::Button("Load"))
+			if (mySongLoad && mySongLoadPath == it.first && myChartPlayer.IsLoading())
+			{
+				ImGui::ProgressBar(mySongLoad->GetProgress(), { 100.f, 0 });
+				ImGui::SameLine();
+				if (ImGui::Button("Cancel"))
+					mySongLoad->Cancel();
+			}
+			else if (ImGui::Button("Load"))
+			{
 				LoadSong(it.first);
+			}
 
 			ImGui::PopID();
 		}
@@ -414,6 +437,14 @@ void ChartTestWindow::ImGui_ChartList_Path()
 
 	if (ImGui::Button("Refresh"))
 		RefreshSongList();
+
+	if (mySongLibrary.IsScanning())
+	{
+		ImGui::Text("Scanning, %zu songs found", mySongLibrary.GetScannedSongCount());
+		ImGui::SameLine();
+		if (ImGui::SmallButton("Cancel scan"))
+			mySongLibrary.CancelScan();
+	}
 }
 
 void ChartTestWindow::ImGui_Controllers()
@@ -425,6 +456,8 @@ void ChartTestWindow::ImGui_Controllers()
 	if (ImGui::Button("Add Human"))
 		myChartPlayer.AddController<ChartHumanController>();
 
+	ImGui_Replay();
+
 	ChartController* removedController = nullptr;
 
 	for (std::size_t i = 0; i < myChartPlayer.GetControllers().size(); ++i)
@@ -450,6 +483,132 @@ void ChartTestWindow::ImGui_Controllers()
 		myChartPlayer.RemoveController(*removedController);
 }
 
+void ChartTestWindow::ImGui_Replay()
+{
+	const ChartData* chart = myChartPlayer.GetChartData();
+	const std::vector<std::unique_ptr<ChartController>>& controllers = myChartPlayer.GetControllers();
+
+	// Controllers without an input device play by themselves, so there's nothing to record.
+	const bool isRecording = std::any_of(controllers.begin(), controllers.end(), [](const std::unique_ptr<ChartController>& aController) { return aController->IsRecordingInputs(); });
+
+	ImGui::BeginDisabled(chart == nullptr);
+
+	if (!isRecording)
+	{
+		if (ImGui::Button("Record replay"))
+		{
+			for (const std::unique_ptr<ChartController>& controller : controllers)
+			{
+				if (controller->GetInputDevice() != nullptr)
+					controller->SetRecordingInputs(true);
+			}
+
+			myReplayStatus = "Recording";
+		}
+	}
+	else if (ImGui::Button("Save replay"))
+	{
+		ChartReplay replay(*chart);
+		for (const std::unique_ptr<ChartController>& controller : controllers)
+		{
+			if (!controller->IsRecordingInputs())
+				continue;
+
+			replay.AddController(*controller);
+			controller->SetRecordingInputs(false);
+		}
+
+		myReplayStatus = replay.Save(ChartReplay::GetDefaultPath()) ? "Saved" : "Couldn't save the replay";
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Verify replay"))
+	{
+		ChartReplay replay;
+		if (!replay.Load(ChartReplay::GetDefaultPath()))
+			myReplayStatus = "Couldn't load the replay";
+		else
+			myReplayStatus = replay.Verify(*chart) ? "The replay matches its recorded results" : "The replay doesn't match its recorded results";
+	}
+
+	ImGui::EndDisabled();
+
+	if (!myReplayStatus.empty())
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(myReplayStatus.c_str());
+	}
+}
+
+void ChartTestWindow::ImGui_Calibration()
+{
+	ChartCalibration& calibration = myChartPlayer.GetCalibration();
+
+	int hitWindowMilliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(calibration.GetHitWindow()).count());
+	if (ImGui::InputInt("Hit window (ms)", &hitWindowMilliseconds, 10, 50))
+		calibration.SetHitWindow(std::chrono::milliseconds(Atrium::Math::Max(1, hitWindowMilliseconds)));
+
+	int audioVideoOffsetMilliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(calibration.GetAudioVideoOffset()).count());
+	if (ImGui::InputInt("Audio/video offset (ms)", &audioVideoOffsetMilliseconds, 1, 10))
+		calibration.SetAudioVideoOffset(std::chrono::milliseconds(audioVideoOffsetMilliseconds));
+
+	ImGui::SeparatorText("Input offsets");
+	ImGui::TextDisabled("Tap along to the beat while the chart plays, then apply the estimate.");
+
+	for (std::size_t i = 0; i < myChartPlayer.GetControllers().size(); ++i)
+	{
+		ChartController& controller = *myChartPlayer.GetControllers()[i];
+		const char* device = controller.GetInputDevice();
+		if (device == nullptr)
+			continue;
+
+		ImGui::PushID(static_cast<int>(i));
+
+		int inputOffsetMilliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(calibration.GetInputOffset(device)).count());
+		if (ImGui::InputInt(std::format("{} ({})", device, controller.GetName()).c_str(), &inputOffsetMilliseconds, 1, 10))
+			calibration.SetInputOffset(device, std::chrono::milliseconds(inputOffsetMilliseconds));
+
+		if (!controller.IsRecordingTaps())
+		{
+			if (ImGui::SmallButton("Tap along"))
+				controller.SetRecordingTaps(true);
+		}
+		else
+		{
+			std::optional<ChartCalibration::OffsetEstimate> estimate;
+			if (myChartPlayer.GetChartData())
+				estimate = ChartCalibration::EstimateOffset(ChartCalibration::GetTapOffsets(controller.GetRecordedTaps(), *myChartPlayer.GetChartData()));
+
+			if (estimate)
+			{
+				ImGui::Text("%zu taps, off by %.1f ms (deviation %.1f ms, %zu outliers left out)",
+					controller.GetRecordedTaps().size(),
+					static_cast<float>(estimate->Offset.count()) / 1000.f,
+					static_cast<float>(estimate->Deviation.count()) / 1000.f,
+					estimate->RejectedCount);
+			}
+			else
+			{
+				ImGui::Text("%zu taps, not enough for an estimate yet", controller.GetRecordedTaps().size());
+			}
+
+			ImGui::BeginDisabled(!estimate.has_value());
+			if (ImGui::SmallButton("Apply"))
+			{
+				calibration.SetInputOffset(device, calibration.GetInputOffset(device) + estimate->Offset);
+				controller.SetRecordingTaps(false);
+			}
+			ImGui::EndDisabled();
+
+			ImGui::SameLine();
+			if (ImGui::SmallButton("Cancel"))
+				controller.SetRecordingTaps(false);
+		}
+
+		ImGui::PopID();
+	}
+}
+
 void ChartTestWindow::ImGui_Tracks()
 {
 	ZoneScoped;
@@ -586,12 +745,17 @@ void ChartTestWindow::ImGui_Track(const ImGui_ChartDrawParameters& someParameter
 	ZoneScoped;
 
 	const TrackSettings& trackSettings = myTrackSettings.at(aTrack.GetType());
-	if (!aTrack.GetNoteRanges().contains(trackSettings.Difficulty))
+	if (aTrack.GetNotes(trackSettings.Difficulty).empty())
 		return;
 
 	ImGui_DrawChart_Lanes(someParameters, aTrack.GetType());
 
-	const std::vector<ChartNoteRange>& difficultyNotes = aTrack.GetNoteRanges().at(trackSettings.Difficulty);
+	const std::span<const ChartNoteRange> difficultyNotes = aTrack.GetNoteSpanInRange(
+		trackSettings.Difficulty,
+		someParameters.PointToTime(0.f),
+		someParameters.PointToTime(someParameters.Size.X)
+	);
+
 	for (const ChartNoteRange& note : difficultyNotes)
 	{
 		ImGui_DrawChart_Note(someParameters, note, aTrack.GetType(), trackSettings.ShowOpen);
@@ -615,37 +779,27 @@ void ChartTestWindow::ImGui_DrawChart_Beats(const ImGui_ChartDrawParameters& som
 
 	ImDrawList* drawList = ImGui::GetWindowDrawList();
 
-	std::uint32_t beat = 0;
+	const std::span<const ChartData::Beat> beats = myChartPlayer.GetChartData()->GetBeatsInRange(
+		someParameters.PointToTime(0.f),
+		someParameters.PointToTime(someParameters.Size.X)
+	);
 
-	const std::vector<ChartData::TempoSection>& tempoSections = myChartPlayer.GetChartData()->GetTempoSections();
-	for (auto section = tempoSections.cbegin(); section != tempoSections.cend(); section++)
+	for (const ChartData::Beat& beat : beats)
 	{
-		const auto next = section + 1;
-		const std::chrono::microseconds start = section->TimeStart;
-		const std::chrono::microseconds end = (next != tempoSections.cend()) ? next->TimeStart : myChartPlayer.GetChartData()->GetDuration();
-
-		std::chrono::microseconds beatTime = start;
-		const ChartData::TimeSignature& timeSignature = myChartPlayer.GetChartData()->GetTimeSignatureAt(start);
-		while (beatTime < end)
+		const float trackPosition = someParameters.TimeToPoint(beat.Time);
+		if (beat.IsDownbeat)
 		{
-			const float trackPosition = someParameters.TimeToPoint(beatTime);
-			if (beat == 0)
-			{
-				drawList->AddLine(
-					ImVec2(someParameters.Point.X + trackPosition, someParameters.Point.Y),
-					ImVec2(someParameters.Point.X + trackPosition, someParameters.Point.Y + someParameters.Size.Y),
-					IM_COL32(180, 180, 180, 255), 4.f);
-			}
-			else
-			{
-				drawList->AddLine(
-					ImVec2(someParameters.Point.X + trackPosition, someParameters.Point.Y),
-					ImVec2(someParameters.Point.X + trackPosition, someParameters.Point.Y + someParameters.Size.Y),
-					IM_COL32(60, 60, 60, 255), 2.f);
-			}
-
-			beat = (beat + 1) % timeSignature.Numerator;
-			beatTime += section->TimePerBeat;
+			drawList->AddLine(
+				ImVec2(someParameters.Point.X + trackPosition, someParameters.Point.Y),
+				ImVec2(someParameters.Point.X + trackPosition, someParameters.Point.Y + someParameters.Size.Y),
+				IM_COL32(180, 180, 180, 255), 4.f);
+		}
+		else
+		{
+			drawList->AddLine(
+				ImVec2(someParameters.Point.X + trackPosition, someParameters.Point.Y),
+				ImVec2(someParameters.Point.X + trackPosition, someParameters.Point.Y + someParameters.Size.Y),
+				IM_COL32(60, 60, 60, 255), 2.f);
 		}
 	}
 }
@@ -811,26 +965,19 @@ void ChartTestWindow::RefreshSongList()
 	if (!std::filesystem::exists(mySongsDirectory) || !std::filesystem::is_directory(mySongsDirectory))
 		return;
 
-	myChartInfos.clear();
+	// Opening shows the songs from the directory's index right away, then the scan fills in what changed since.
+	if (mySongLibrary.GetDirectory() != mySongsDirectory)
+		mySongLibrary.Open(mySongsDirectory);
 
-	for (const auto& entry : std::filesystem::directory_iterator(mySongsDirectory))
-	{
-		const std::filesystem::path songIni = entry.path() / "song.ini";
-
-		if (!std::filesystem::exists(songIni))
-			continue;
-
-		std::unique_ptr<ChartInfo> chartInfo = std::make_unique<ChartInfo>();
-		chartInfo->Load(songIni);
-		myChartInfos[songIni] = std::move(chartInfo);
-	}
+	mySongLibrary.StartScan();
 }
 
 void ChartTestWindow::LoadSong(const std::filesystem::path& aSong)
 {
 	ZoneScoped;
 	
-	const std::unique_ptr<ChartInfo>& chart = myChartInfos.at(aSong);
-	myCurrentSong = chart->GetSongInfo().Title;
-	myChartPlayer.LoadChart(aSong);
+	const ChartInfo& chart = mySongLibrary.GetSongs().at(aSong).Info;
+	myCurrentSong = chart.GetSongInfo().Title;
+	mySongLoad = myChartPlayer.LoadChartAsync(aSong);
+	mySongLoadPath = aSong;
 }
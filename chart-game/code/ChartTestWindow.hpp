@@ -2,6 +2,7 @@
 #pragma once
 
 #include "ChartData.hpp"
+#include "SongLibrary.hpp"
 
 #include "Atrium_Math.hpp"
 
@@ -14,6 +15,7 @@ struct ImGui_ChartDrawParameters
 	Atrium::Vector2 Point;
 	Atrium::Vector2 Size;
 	std::function<float(std::chrono::microseconds aTime)> TimeToPoint;
+	std::function<std::chrono::microseconds(float aPoint)> PointToTime;
 };
 
 class ChartController;
@@ -40,6 +42,8 @@ private:
 	void ImGui_ChartList_Path();
 
 	void ImGui_Controllers();
+	void ImGui_Replay();
+	void ImGui_Calibration();
 
 	void ImGui_Player_PlayControls();
 	void ImGui_Player_LookAheadControl();
@@ -66,12 +70,15 @@ private:
 
 	std::filesystem::path mySongsDirectory;
 	std::array<char, 512> mySongsDirectoryBuffer;
-	std::map<std::filesystem::path, std::unique_ptr<ChartInfo>> myChartInfos;
+	SongLibrary mySongLibrary;
 
 	std::string myCurrentSong;
+	std::shared_ptr<ChartData::LoadStatus> mySongLoad;
+	std::filesystem::path mySongLoadPath;
 
 	ChartPlayer& myChartPlayer;
 	ChartRenderer& myChartRenderer;
 	std::map<ChartTrackType, TrackSettings> myTrackSettings;
+	std::string myReplayStatus;
 	std::chrono::microseconds myLookAhead;
 };
@@ -6,124 +6,182 @@
 #include "Atrium_Diagnostics.hpp"
 #include "Atrium_Math.hpp"
 
-void ChartTrackLoadData::AddNote(std::chrono::microseconds aTime, std::uint8_t aNote, std::uint8_t aVelocity)
+ChartTrackLoadData::ChartTrackLoadData(std::pmr::memory_resource* aResource)
+	: NoteRanges(MidiNoteCount, aResource)
+	, SysExEvents(aResource)
+	, Lyrics(aResource)
 {
+}
+
+void ChartTrackLoadData::AddNote(std::uint32_t aTick, std::chrono::microseconds aTime, std::uint8_t aNote, std::uint8_t aVelocity)
+{
+	if (aNote >= MidiNoteCount)
+		return;
+
 	// Run this even when velocity = 1, to make it "restart" the note.
-	if (myPartialNotes.contains(aNote))
+	if (myPartialNotes.test(aNote))
 	{
-		NoteRanges.push_back({ aNote, { myPartialNotes.at(aNote), aTime } });
-		myPartialNotes.erase(aNote);
+		NoteRanges[aNote].push_back({ myPartialNoteStarts[aNote], aTime, myPartialNoteStartTicks[aNote] });
+		myPartialNotes.reset(aNote);
 	}
 
 	if (aVelocity > 0)
-		myPartialNotes[aNote] = aTime;
+	{
+		myPartialNoteStarts[aNote] = aTime;
+		myPartialNoteStartTicks[aNote] = aTick;
+		myPartialNotes.set(aNote);
+	}
+}
+
+void ChartTrackLoadData::AddNotes(std::span<const std::uint32_t> someTicks, std::span<const std::chrono::microseconds> someTimes, std::span<const std::uint8_t> someNotes, std::span<const std::uint8_t> someVelocities)
+{
+	ZoneScoped;
+
+	Atrium::Debug::Assert(someTicks.size() == someTimes.size() && someTimes.size() == someNotes.size() && someNotes.size() == someVelocities.size(), "Note arrays need to be the same length.");
+
+	// Every range starts with a note on, so counting those gives each note's range count up front.
+	std::array<std::uint32_t, MidiNoteCount> noteOnCounts = { };
+	for (std::size_t i = 0; i < someNotes.size(); ++i)
+	{
+		if (someNotes[i] < MidiNoteCount && someVelocities[i] > 0)
+			++noteOnCounts[someNotes[i]];
+	}
+
+	for (std::size_t note = 0; note < MidiNoteCount; ++note)
+		NoteRanges[note].reserve(NoteRanges[note].size() + noteOnCounts[note]);
+
+	for (std::size_t i = 0; i < someNotes.size(); ++i)
+		AddNote(someTicks[i], someTimes[i], someNotes[i], someVelocities[i]);
 }
 
 void ChartTrackLoadData::AddSysEx(std::chrono::microseconds aTime, const std::span<const std::uint8_t>& someData)
 {
-	SysExEvents.emplace_back(aTime, std::vector<std::uint8_t>(someData.begin(), someData.end()));
+	SysExEvents.emplace_back(aTime, std::pmr::vector<std::uint8_t>(someData.begin(), someData.end(), SysExEvents.get_allocator()));
 }
 
-void ChartTrackLoadData::AddLyric(std::chrono::microseconds aTime, const std::string& aText)
+void ChartTrackLoadData::AddLyric(std::chrono::microseconds aTime, std::string_view aText)
 {
-	Lyrics.emplace(aTime, aText);
+	// Events come in time order, so this is almost always an append.
+	const auto position = std::upper_bound(
+		Lyrics.begin(), Lyrics.end(), aTime,
+		[](std::chrono::microseconds aTime, const std::pair<std::chrono::microseconds, std::pmr::string>& aLyric) { return aTime < aLyric.first; }
+	);
+
+	Lyrics.emplace(position, aTime, std::pmr::string(aText, Lyrics.get_allocator()));
 }
 
-std::unique_ptr<ChartTrack> ChartTrack::CreateTrackByName(const std::string& aName)
+std::unique_ptr<ChartTrack> ChartTrack::CreateTrack(ChartTrackType aType)
 {
 	std::unique_ptr<ChartTrack> track;
-	if (aName == "GUITAR")
-	{
-		track.reset(new ChartGuitarTrack());
-		track->myType = ChartTrackType::LeadGuitar;
-	}
-	else if (aName == "RHYTHM")
-	{
-		track.reset(new ChartGuitarTrack());
-		track->myType = ChartTrackType::RhythmGuitar;
-	}
-	else if (aName == "BASS")
+
+	switch (aType)
 	{
+	case ChartTrackType::LeadGuitar:
+	case ChartTrackType::RhythmGuitar:
+	case ChartTrackType::BassGuitar:
 		track.reset(new ChartGuitarTrack());
-		track->myType = ChartTrackType::BassGuitar;
+		break;
+	default:
+		return track;
 	}
-	else
+
+	track->myType = aType;
+	return track;
+}
+
+std::unique_ptr<ChartTrack> ChartTrack::CreateTrackByName(const std::string& aName)
+{
+	const std::optional<ChartTrackType> trackType = GetTrackTypeByName(aName);
+	if (!trackType.has_value())
 	{
 		Atrium::Debug::LogError("Unknown track type: %s", aName.c_str());
+		return nullptr;
 	}
 
-	return track;
+	return CreateTrack(trackType.value());
+}
+
+std::optional<ChartTrackType> ChartTrack::GetTrackTypeByName(std::string_view aName)
+{
+	if (aName == "GUITAR")
+		return ChartTrackType::LeadGuitar;
+	else if (aName == "RHYTHM")
+		return ChartTrackType::RhythmGuitar;
+	else if (aName == "BASS")
+		return ChartTrackType::BassGuitar;
+	else
+		return { };
 }
 
 const ChartNoteRange* ChartGuitarTrack::GetClosestNote(ChartTrackDifficulty aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const
 {
 	ZoneScoped;
 
-	const std::vector<ChartNoteRange>& difficultyNotes = myNoteRanges.at(aDifficulty);
+	if (aLane >= LaneCount)
+		return nullptr;
 
-	const ChartNoteRange* closestNote = nullptr;
-	std::chrono::microseconds closestDistance = std::chrono::microseconds::max();
+	const DifficultyNotes& difficulty = myDifficulties[static_cast<std::size_t>(aDifficulty)];
+	const std::vector<ChartNoteRange>& difficultyNotes = difficulty.Notes;
+	const std::vector<std::uint32_t>& laneNotes = difficulty.LaneNotes[aLane];
+	const std::size_t next = FindLaneNote(difficulty, aLane, aTimepoint);
 
-	for (const ChartNoteRange& noteRange : difficultyNotes)
-	{
-		if (noteRange.Lane != aLane)
-			continue;
+	// Since notes in a lane don't overlap, the closest one is either the last to start before the timepoint or the first after it.
+	const ChartNoteRange* previousNote = (next > 0) ? &difficultyNotes[laneNotes[next - 1]] : nullptr;
+	const ChartNoteRange* nextNote = (next < laneNotes.size()) ? &difficultyNotes[laneNotes[next]] : nullptr;
 
-		const std::chrono::microseconds closestPointInRange = Atrium::Math::Clamp(aTimepoint, noteRange.Start, noteRange.End);
-		const std::chrono::microseconds distance = Atrium::Math::Abs(closestPointInRange - aTimepoint);
+	if (!previousNote || !nextNote)
+		return previousNote ? previousNote : nextNote;
 
-		if (distance < closestDistance)
-		{
-			closestDistance = distance;
-			closestNote = &noteRange;
-		}
-	}
-
-	return closestNote;
+	const std::chrono::microseconds previousDistance = Atrium::Math::Max(aTimepoint - previousNote->End, std::chrono::microseconds(0));
+	const std::chrono::microseconds nextDistance = nextNote->Start - aTimepoint;
+	return (nextDistance < previousDistance) ? nextNote : previousNote;
 }
 
-const ChartNoteRange* ChartGuitarTrack::GetNextNote(ChartTrackDifficulty aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const
+std::span<const std::uint32_t> ChartGuitarTrack::GetLaneNotes(ChartTrackDifficulty aDifficulty, std::uint8_t aLane) const
 {
-	ZoneScoped;
+	if (aLane >= LaneCount)
+		return { };
 
-	const std::vector<ChartNoteRange>& difficultyNotes = myNoteRanges.at(aDifficulty);
+	return myDifficulties[static_cast<std::size_t>(aDifficulty)].LaneNotes[aLane];
+}
 
-	const ChartNoteRange* closestNote = nullptr;
-	std::chrono::microseconds closestDistance = std::chrono::microseconds::max();
+const ChartChord* ChartGuitarTrack::GetNextChord(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aTimepoint) const
+{
+	const std::vector<ChartChord>& chords = myDifficulties[static_cast<std::size_t>(aDifficulty)].Chords;
+	const auto next = std::lower_bound(
+		chords.begin(), chords.end(), aTimepoint,
+		[](const ChartChord& aChord, std::chrono::microseconds aTimepoint) { return aChord.Start < aTimepoint; }
+	);
 
-	for (const ChartNoteRange& noteRange : difficultyNotes)
-	{
-		if (noteRange.Lane != aLane)
-			continue;
+	return next != chords.end() ? &*next : nullptr;
+}
 
-		if (noteRange.Start < aTimepoint)
-			continue;
+const ChartNoteRange* ChartGuitarTrack::GetNextNote(ChartTrackDifficulty aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const
+{
+	ZoneScoped;
 
-		const std::chrono::microseconds closestPointInRange = Atrium::Math::Clamp(aTimepoint, noteRange.Start, noteRange.End);
-		const std::chrono::microseconds distance = Atrium::Math::Abs(closestPointInRange - aTimepoint);
+	if (aLane >= LaneCount)
+		return nullptr;
 
-		if (distance < closestDistance)
-		{
-			closestDistance = distance;
-			closestNote = &noteRange;
-		}
-	}
+	const DifficultyNotes& difficulty = myDifficulties[static_cast<std::size_t>(aDifficulty)];
+	const std::vector<std::uint32_t>& laneNotes = difficulty.LaneNotes[aLane];
+	const std::size_t next = FindLaneNote(difficulty, aLane, aTimepoint);
 
-	return closestNote;
+	return (next < laneNotes.size()) ? &difficulty.Notes[laneNotes[next]] : nullptr;
 }
 
 std::vector<ChartNoteRange> ChartGuitarTrack::GetNotesInRange(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aStart, std::chrono::microseconds anEnd) const
 {
 	ZoneScoped;
 
-	const std::vector<ChartNoteRange>& difficultyNotes = myNoteRanges.at(aDifficulty);
+	const std::span<const ChartNoteRange> candidates = GetNoteSpanInRange(aDifficulty, aStart, anEnd);
 
 	std::vector<ChartNoteRange> notesInRange;
-	notesInRange.reserve(difficultyNotes.size());
+	notesInRange.reserve(candidates.size());
 
-	for (const ChartNoteRange& noteRange : difficultyNotes)
+	for (const ChartNoteRange& noteRange : candidates)
 	{
-		if (noteRange.End < aStart || noteRange.Start >= anEnd)
+		if (noteRange.End < aStart)
 			continue;
 
 		notesInRange.push_back(noteRange);
@@ -132,70 +190,182 @@ std::vector<ChartNoteRange> ChartGuitarTrack::GetNotesInRange(ChartTrackDifficul
 	return notesInRange;
 }
 
+std::span<const ChartNoteRange> ChartGuitarTrack::GetNoteSpanInRange(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aStart, std::chrono::microseconds anEnd) const
+{
+	ZoneScoped;
+
+	const DifficultyNotes& difficulty = myDifficulties[static_cast<std::size_t>(aDifficulty)];
+	const std::vector<std::chrono::microseconds>& maxEnds = difficulty.MaxEnds;
+	const std::vector<std::chrono::microseconds>& starts = difficulty.Starts;
+
+	// Everything before the first note whose running max end reaches aStart has ended before the range.
+	const std::size_t first = static_cast<std::size_t>(std::lower_bound(maxEnds.begin(), maxEnds.end(), aStart) - maxEnds.begin());
+	const std::size_t last = static_cast<std::size_t>(std::lower_bound(starts.begin() + first, starts.end(), anEnd) - starts.begin());
+
+	return std::span<const ChartNoteRange>(difficulty.Notes.data() + first, last - first);
+}
+
 bool ChartGuitarTrack::Load(const ChartTrackLoadData& someData)
 {
 	ZoneScoped;
 
-	myNoteRanges.clear();
+	myDifficulties = { };
 	myMarkers.clear();
 
-	return Load_AddNotes(someData)
-		&& Load_UpdateDefaultNoteTypes()
-		&& Load_ProcessMarkers(someData)
-		&& Load_ProcessSysEx(someData)
+	NoteStartTicks startTicks(ChartTrackDifficultyCount, someData.GetResource());
+	NoteModifiers modifiers(ChartTrackDifficultyCount, someData.GetResource());
+
+	const bool isLoaded = Load_AddNotes(someData, startTicks)
+		&& Load_UpdateDefaultNoteTypes(someData, startTicks)
+		&& Load_ProcessMarkers(someData, modifiers)
+		&& Load_ProcessSysEx(someData, modifiers)
+		&& Load_ApplyNoteModifiers(modifiers)
 		;
+
+	if (isLoaded)
+		BuildIndices();
+
+	return isLoaded;
+}
+
+void ChartGuitarTrack::LoadCache(ChartCache::Reader& aReader)
+{
+	ZoneScoped;
+
+	myDifficulties = { };
+	myMarkers.clear();
+
+	for (DifficultyNotes& difficulty : myDifficulties)
+		aReader.ReadArray(difficulty.Notes);
+
+	aReader.ReadArray(myMarkers);
+
+	BuildIndices();
 }
 
-bool ChartGuitarTrack::Load_AddNotes(const ChartTrackLoadData& someData)
+void ChartGuitarTrack::SaveCache(ChartCache::Writer& aWriter) const
 {
 	ZoneScoped;
 
-	for (const auto& midiNoteRange : someData.NoteRanges)
+	for (const DifficultyNotes& difficulty : myDifficulties)
+		aWriter.WriteArray(std::span<const ChartNoteRange>(difficulty.Notes));
+
+	aWriter.WriteArray(std::span<const MarkerRange>(myMarkers));
+}
+
+bool ChartGuitarTrack::Load_AddNotes(const ChartTrackLoadData& someData, NoteStartTicks& outStartTicks)
+{
+	ZoneScoped;
+
+	std::array<std::size_t, ChartTrackDifficultyCount> noteCounts = { };
+	for (std::uint8_t midiNote = 0; midiNote < ChartTrackLoadData::MidiNoteCount; ++midiNote)
+	{
+		std::uint8_t lane = 0;
+		std::uint8_t octave = 0;
+		MidiDecoder::DecomposeNoteNumber(midiNote, octave, lane);
+		if (octave >= 5 && octave < 9 && lane < 5)
+			noteCounts[octave - 5] += someData.NoteRanges[midiNote].size();
+	}
+
+	// Notes are staged with their start tick, so the ticks stay lined up with the notes through the sort.
+	struct StagedNote
 	{
-		const std::uint8_t midiNote = midiNoteRange.first;
-		const std::pair<std::chrono::microseconds, std::chrono::microseconds>& range = midiNoteRange.second;
+		ChartNoteRange Note;
+		std::uint32_t StartTick = 0;
+	};
 
+	std::pmr::vector<std::pmr::vector<StagedNote>> stagedNotes(ChartTrackDifficultyCount, someData.GetResource());
+	for (std::size_t i = 0; i < ChartTrackDifficultyCount; ++i)
+		stagedNotes[i].reserve(noteCounts[i]);
+
+	for (std::uint8_t midiNote = 0; midiNote < ChartTrackLoadData::MidiNoteCount; ++midiNote)
+	{
 		std::uint8_t lane = 0;
 		std::uint8_t octave = 0;
 		MidiDecoder::DecomposeNoteNumber(midiNote, octave, lane);
-		if (octave < 5 && octave >= 9)
+		if (octave < 5 || octave >= 9 || lane >= 5)
 			continue;
 
-		if (lane < 5)
+		for (const ChartTrackLoadData::NoteRange& range : someData.NoteRanges[midiNote])
 		{
-			ChartNoteRange& newNoteRange = myNoteRanges[ChartTrackDifficulty(octave - 5)].emplace_back();
-			newNoteRange.Lane = lane;
-			newNoteRange.Start = range.first;
-			newNoteRange.End = range.second;
+			StagedNote& staged = stagedNotes[octave - 5].emplace_back();
+			staged.Note.Lane = lane;
+			staged.Note.Start = range.Start;
+			staged.Note.End = range.End;
+			staged.StartTick = range.StartTick;
 		}
 	}
 
-#if IS_DEBUG_BUILD
-	// Debug-only sorting of notes to make them make a bit more sense when inspecting.
-	for (auto& difficulty : myNoteRanges)
+	// Lookups binary search the notes, so they need to be in time order.
+	for (std::size_t i = 0; i < ChartTrackDifficultyCount; ++i)
 	{
-		std::sort(difficulty.second.begin(), difficulty.second.end(), [](const ChartNoteRange& a, const ChartNoteRange& b)
+		std::pmr::vector<StagedNote>& staged = stagedNotes[i];
+		std::stable_sort(staged.begin(), staged.end(), [](const StagedNote& a, const StagedNote& b)
 			{
-				return a.Start < b.Start;
+				return a.Note.Start < b.Note.Start;
 			}
 		);
+
+		std::vector<ChartNoteRange>& notes = myDifficulties[i].Notes;
+		notes.reserve(staged.size());
+		outStartTicks[i].reserve(staged.size());
+		for (const StagedNote& note : staged)
+		{
+			notes.push_back(note.Note);
+			outStartTicks[i].push_back(note.StartTick);
+		}
 	}
-#endif
 
 	return true;
 }
 
-bool ChartGuitarTrack::Load_UpdateDefaultNoteTypes()
+bool ChartGuitarTrack::Load_UpdateDefaultNoteTypes(const ChartTrackLoadData& someData, const NoteStartTicks& someStartTicks)
 {
 	ZoneScoped;
 
-	// Todo: Update default note types based on surrounding notes.
 	// https://github.com/TheNathannator/GuitarGame_ChartFormats/blob/main/doc/FileFormats/.mid/Standard/5-Fret%20Guitar.md#note-mechanics
+	// A note is a HOPO when it starts within the threshold of the previous note, unless it's a chord or repeats a lane of the previous note.
+	// Forced markers are applied on top of this afterwards.
+
+	const std::uint16_t ticksPerQuarterNote = someData.Tempos ? someData.Tempos->GetTicksPerQuarterNote() : TempoMap().GetTicksPerQuarterNote();
+	const std::uint32_t hopoThreshold = (ticksPerQuarterNote / 3u) + (ticksPerQuarterNote / 48u);
+
+	for (std::size_t difficultyIndex = 0; difficultyIndex < ChartTrackDifficultyCount; ++difficultyIndex)
+	{
+		std::vector<ChartNoteRange>& notes = myDifficulties[difficultyIndex].Notes;
+		const std::pmr::vector<std::uint32_t>& startTicks = someStartTicks[difficultyIndex];
+
+		std::optional<std::uint32_t> previousTick;
+		std::uint8_t previousLanes = 0;
+
+		for (std::size_t chordStart = 0; chordStart < notes.size();)
+		{
+			std::size_t chordEnd = chordStart;
+			std::uint8_t lanes = 0;
+			while (chordEnd < notes.size() && notes[chordEnd].Start == notes[chordStart].Start)
+				lanes |= static_cast<std::uint8_t>(1u << notes[chordEnd++].Lane);
+
+			const std::uint32_t tick = startTicks[chordStart];
+
+			const bool isChord = (lanes & (lanes - 1)) != 0;
+			const bool isHOPO = previousTick.has_value()
+				&& !isChord
+				&& (lanes & previousLanes) == 0
+				&& (tick - previousTick.value()) <= hopoThreshold;
+
+			for (std::size_t i = chordStart; i < chordEnd; ++i)
+				notes[i].Type = isHOPO ? ChartNoteType::HOPO : ChartNoteType::Strum;
+
+			previousTick = tick;
+			previousLanes = lanes;
+			chordStart = chordEnd;
+		}
+	}
 
 	return true;
 }
 
-bool ChartGuitarTrack::Load_ProcessSysEx(const ChartTrackLoadData& someData)
+bool ChartGuitarTrack::Load_ProcessSysEx(const ChartTrackLoadData& someData, NoteModifiers& outModifiers)
 {
 	ZoneScoped;
 
@@ -205,62 +375,50 @@ bool ChartGuitarTrack::Load_ProcessSysEx(const ChartTrackLoadData& someData)
 		std::optional<std::chrono::microseconds> TapFlagStart;
 	};
 
-	std::map<ChartTrackDifficulty, SysExPerDifficulty> perDifficulty;
+	std::array<SysExPerDifficulty, ChartTrackDifficultyCount> perDifficulty;
 
-	auto handleSysExEvent = [&](const std::chrono::microseconds& aTime, const std::vector<std::uint8_t>& someData) -> bool
+	auto handleSysExEvent = [&](const std::chrono::microseconds& aTime, std::span<const std::uint8_t> someData) -> bool
 		{
-			ZoneScoped;
-
 			if (someData.size() != 7)
 				return false;
 
 			if (someData[0] != 'P' || someData[1] != 'S')
 				return false;
 
-			static constexpr std::uint8_t Easy = 0;
-			static constexpr std::uint8_t Medium = 1;
-			static constexpr std::uint8_t Hard = 2;
-			static constexpr std::uint8_t Expert = 3;
 			static constexpr std::uint8_t All = 0xFF;
 
-			static constexpr std::uint8_t OpenNote = 0x10;
-			static constexpr std::uint8_t TapNote = 0x40;
+			static constexpr std::uint8_t OpenNote = 0x01;
+			static constexpr std::uint8_t TapNote = 0x04;
 
 			const std::uint8_t difficulty = someData[4];
 			const std::uint8_t type = someData[5];
 			const std::uint8_t value = someData[6];
 
+			if (type != OpenNote && type != TapNote)
+				return false;
+
 			for (std::uint8_t i = 0; i < ChartTrackDifficultyCount; ++i)
 			{
 				if (difficulty != All && i != difficulty)
 					continue;
 
-				SysExPerDifficulty& perDiff = perDifficulty[ChartTrackDifficulty(i)];
-				std::optional<std::chrono::microseconds>* flag = nullptr;
-				if (type == 0x01)
-					flag = &perDiff.OpenFlagStart;
-				else if (type == 0x04)
-					flag = &perDiff.TapFlagStart;
+				SysExPerDifficulty& perDiff = perDifficulty[i];
+				std::optional<std::chrono::microseconds>& flag = (type == OpenNote ? perDiff.OpenFlagStart : perDiff.TapFlagStart);
 
-				if (flag->has_value() == (value != 0))
+				if (flag.has_value() == (value != 0))
 					throw std::runtime_error("Overlapping sysex events. Please check.");
 
 				if (value != 0)
 				{
-					*flag = aTime;
+					flag = aTime;
 				}
 				else
 				{
-					Load_ForEachNoteInRange([type](ChartNoteRange& aRange) {
-						if (type == 0x01)
-							aRange.CanBeOpen = true;
-						else if (type == 0x04)
-							aRange.Type = ChartNoteType::Tap;
-						},
-						ChartTrackLoadData::PerDifficultyFlag().set(i),
-						flag->value(),
-						aTime);
-					(*flag).reset();
+					NoteModifier& modifier = outModifiers[i].emplace_back();
+					modifier.Type = (type == OpenNote ? NoteModifierType::Open : NoteModifierType::Tap);
+					modifier.Start = flag.value();
+					modifier.End = aTime;
+					flag.reset();
 				}
 			}
 
@@ -288,78 +446,153 @@ bool ChartGuitarTrack::Load_ProcessSysEx(const ChartTrackLoadData& someData)
 	return true;
 }
 
-bool ChartGuitarTrack::Load_ProcessMarkers(const ChartTrackLoadData& someData)
+bool ChartGuitarTrack::Load_ProcessMarkers(const ChartTrackLoadData& someData, NoteModifiers& outModifiers)
 {
 	ZoneScoped;
 
-	for (const auto& midiNoteRange : someData.NoteRanges)
+	auto addModifier = [&outModifiers](int aDifficulty, NoteModifierType aType, const ChartTrackLoadData::NoteRange& aRange)
+		{
+			if (aDifficulty < 0 || aDifficulty >= static_cast<int>(ChartTrackDifficultyCount))
+				return;
+
+			NoteModifier& modifier = outModifiers[aDifficulty].emplace_back();
+			modifier.Type = aType;
+			modifier.Start = aRange.Start;
+			modifier.End = aRange.End;
+		};
+
+	std::array<std::size_t, ChartTrackDifficultyCount> firstMarkerModifiers = { };
+	for (std::size_t i = 0; i < ChartTrackDifficultyCount; ++i)
+		firstMarkerModifiers[i] = outModifiers[i].size();
+
+	for (std::uint8_t midiNote = 0; midiNote < ChartTrackLoadData::MidiNoteCount; ++midiNote)
 	{
-		const std::uint8_t midiNote = midiNoteRange.first;
-		const std::pair<std::chrono::microseconds, std::chrono::microseconds>& range = midiNoteRange.second;
-		if (midiNote < 103) // Per difficulty midi notes.
+		for (const ChartTrackLoadData::NoteRange& range : someData.NoteRanges[midiNote])
 		{
-			std::uint8_t lane = 0;
-			std::uint8_t octave = 0;
-			MidiDecoder::DecomposeNoteNumber(midiNote, octave, lane);
+			if (midiNote < 103) // Per difficulty midi notes.
+			{
+				std::uint8_t lane = 0;
+				std::uint8_t octave = 0;
+				MidiDecoder::DecomposeNoteNumber(midiNote, octave, lane);
 
-			switch (lane)
+				switch (lane)
+				{
+				case 5: // Force HOPO
+					addModifier(octave - 5, NoteModifierType::ForceHOPO, range);
+					break;
+				case 6: // Force strum
+					addModifier(octave - 5, NoteModifierType::ForceStrum, range);
+					break;
+				case 11: // Per-difficulty open markers
+					if (someData.EnhancedOpens)
+						addModifier(octave - 4, NoteModifierType::Open, range); // Enhanced opens is one octave below the difficulty octave they belong to.
+					break;
+				}
+			}
+			else // All difficulty markers
 			{
-			case 5: // Force HOPO
-				Load_ForEachNoteInRange(
-					[](ChartNoteRange& noteRange) { noteRange.Type = ChartNoteType::HOPO; },
-					ChartTrackLoadData::PerDifficultyFlag().set(octave - 5),
-					range.first,
-					range.second
-				);
-				break;
-			case 6: // Force strum
-				Load_ForEachNoteInRange(
-					[](ChartNoteRange& noteRange) { noteRange.Type = ChartNoteType::Strum; },
-					ChartTrackLoadData::PerDifficultyFlag().set(octave - 5),
-					range.first,
-					range.second
-				);
-				break;
-			case 11: // Per-difficulty open markers
-				if (someData.EnhancedOpens)
+				MarkerRange& marker = myMarkers.emplace_back();
+				marker.Start = range.Start;
+				marker.End = range.End;
+
+				switch (midiNote)
 				{
-					Load_ForEachNoteInRange(
-						[](ChartNoteRange& noteRange) { noteRange.CanBeOpen = true; },
-						ChartTrackLoadData::PerDifficultyFlag().set(octave - 4), // Enhanced opens is one octave below the difficulty octave they belong to.
-						range.first,
-						range.second
-					);
+				case 103: marker.Marker = Marker::Solo; break;
+				case 104: marker.Marker = Marker::TapNote; break;
+				case 105: marker.Marker = Marker::P1VersusPhase; break;
+				case 106: marker.Marker = Marker::P2VersusPhase; break;
+
+				case 116: marker.Marker = Marker::StarPower; break;
+
+				case 120: marker.Marker = Marker::BigRockEnding5; break;
+				case 121: marker.Marker = Marker::BigRockEnding4; break;
+				case 122: marker.Marker = Marker::BigRockEnding3; break;
+				case 123: marker.Marker = Marker::BigRockEnding2; break;
+				case 124: marker.Marker = Marker::BigRockEnding1; break;
+
+				case 126: marker.Marker = Marker::TremoloLane; break;
+				case 127: marker.Marker = Marker::TrillLane; break;
+
+				default:
+					Atrium::Debug::LogWarning("Unknown marker note %s (%u)", MidiDecoder::NoteNumberToString(midiNote).c_str(), midiNote);
+					break;
 				}
-				break;
 			}
 		}
-		else // All difficulty markers
-		{
-			MarkerRange& marker = myMarkers.emplace_back();
-			marker.Start = range.first;
-			marker.End = range.second;
+	}
 
-			switch (midiNote)
+	// Ranges are grouped by note number, but later markers win when they overlap, so put them back in the order they ended.
+	for (std::size_t i = 0; i < ChartTrackDifficultyCount; ++i)
+	{
+		std::stable_sort(outModifiers[i].begin() + firstMarkerModifiers[i], outModifiers[i].end(), [](const NoteModifier& aLeft, const NoteModifier& aRight)
 			{
-			case 103: marker.Marker = Marker::Solo; break;
-			case 104: marker.Marker = Marker::TapNote; break;
-			case 105: marker.Marker = Marker::P1VersusPhase; break;
-			case 106: marker.Marker = Marker::P2VersusPhase; break;
+				return aLeft.End < aRight.End;
+			}
+		);
+	}
+
+	return true;
+}
+
+bool ChartGuitarTrack::Load_ApplyNoteModifiers(const NoteModifiers& someModifiers)
+{
+	ZoneScoped;
+
+	for (std::size_t difficultyIndex = 0; difficultyIndex < ChartTrackDifficultyCount; ++difficultyIndex)
+	{
+		const std::pmr::vector<NoteModifier>& modifiers = someModifiers[difficultyIndex];
+		if (modifiers.empty())
+			continue;
+
+		// Visit the modifiers by start time, but apply them in the order they were added so later ones still win.
+		std::pmr::vector<std::uint32_t> byStart(modifiers.size(), someModifiers.get_allocator());
+		for (std::uint32_t i = 0; i < byStart.size(); ++i)
+			byStart[i] = i;
 
-			case 116: marker.Marker = Marker::StarPower; break;
+		std::stable_sort(byStart.begin(), byStart.end(), [&modifiers](std::uint32_t aLeft, std::uint32_t aRight)
+			{
+				return modifiers[aLeft].Start < modifiers[aRight].Start;
+			}
+		);
 
-			case 120: marker.Marker = Marker::BigRockEnding5; break;
-			case 121: marker.Marker = Marker::BigRockEnding4; break;
-			case 122: marker.Marker = Marker::BigRockEnding3; break;
-			case 123: marker.Marker = Marker::BigRockEnding2; break;
-			case 124: marker.Marker = Marker::BigRockEnding1; break;
+		// Modifiers that started at or before the current note, and haven't ended before it. Kept in the order they were added.
+		std::pmr::vector<std::uint32_t> active(someModifiers.get_allocator());
+		std::size_t nextModifier = 0;
 
-			case 126: marker.Marker = Marker::TremoloLane; break;
-			case 127: marker.Marker = Marker::TrillLane; break;
+		for (ChartNoteRange& note : myDifficulties[difficultyIndex].Notes)
+		{
+			while (nextModifier < byStart.size() && modifiers[byStart[nextModifier]].Start <= note.Start)
+			{
+				const std::uint32_t added = byStart[nextModifier++];
+				active.insert(std::upper_bound(active.begin(), active.end(), added), added);
+			}
+
+			// Notes come in start order, so a modifier that ends before this note can't cover any later one either.
+			std::erase_if(active, [&](std::uint32_t aModifier) { return modifiers[aModifier].End < note.Start; });
+
+			for (std::uint32_t modifierIndex : active)
+			{
+				const NoteModifier& modifier = modifiers[modifierIndex];
+
+				// Modifiers only apply to notes that lie fully within them.
+				if (note.End > modifier.End)
+					continue;
 
-			default:
-				Atrium::Debug::LogWarning("Unknown marker note %s (%u)", MidiDecoder::NoteNumberToString(midiNote).c_str(), midiNote);
-				break;
+				switch (modifier.Type)
+				{
+				case NoteModifierType::ForceHOPO:
+					note.Type = ChartNoteType::HOPO;
+					break;
+				case NoteModifierType::ForceStrum:
+					note.Type = ChartNoteType::Strum;
+					break;
+				case NoteModifierType::Open:
+					note.CanBeOpen = true;
+					break;
+				case NoteModifierType::Tap:
+					note.Type = ChartNoteType::Tap;
+					break;
+				}
 			}
 		}
 	}
@@ -367,24 +600,74 @@ bool ChartGuitarTrack::Load_ProcessMarkers(const ChartTrackLoadData& someData)
 	return true;
 }
 
-void ChartGuitarTrack::Load_ForEachNoteInRange(std::function<void(ChartNoteRange&)> aCallback, const ChartTrackLoadData::PerDifficultyFlag& someDifficulties, std::optional<std::chrono::microseconds> aMinimumRange, std::optional<std::chrono::microseconds> aMaximumRange)
+void ChartGuitarTrack::BuildIndices()
 {
 	ZoneScoped;
 
-	for (auto& noteRanges : myNoteRanges)
+	for (DifficultyNotes& difficulty : myDifficulties)
 	{
-		if (!someDifficulties.test(static_cast<std::size_t>(noteRanges.first)))
-			continue;
+		const std::vector<ChartNoteRange>& notes = difficulty.Notes;
+
+		difficulty.Starts.clear();
+		difficulty.Starts.reserve(notes.size());
+
+		std::array<std::size_t, LaneCount> laneNoteCounts = { };
+		std::size_t chordCount = 0;
+		for (std::size_t i = 0; i < notes.size(); ++i)
+		{
+			if (notes[i].Lane < LaneCount)
+				++laneNoteCounts[notes[i].Lane];
+
+			if (i == 0 || notes[i - 1].Start != notes[i].Start)
+				++chordCount;
+		}
+
+		difficulty.LaneNotes = { };
+		difficulty.LaneStarts = { };
+		for (std::uint8_t lane = 0; lane < LaneCount; ++lane)
+		{
+			difficulty.LaneNotes[lane].reserve(laneNoteCounts[lane]);
+			difficulty.LaneStarts[lane].reserve(laneNoteCounts[lane]);
+		}
 
-		for (auto& noteRange : noteRanges.second)
+		difficulty.MaxEnds.clear();
+		difficulty.MaxEnds.reserve(notes.size());
+		difficulty.Chords.clear();
+		difficulty.Chords.reserve(chordCount);
+
+		for (std::uint32_t i = 0; i < notes.size(); ++i)
 		{
-			if (aMinimumRange.has_value() && noteRange.Start < aMinimumRange.value())
-				continue;
+			const ChartNoteRange& note = notes[i];
+
+			difficulty.Starts.push_back(note.Start);
+
+			if (note.Lane < LaneCount)
+			{
+				difficulty.LaneNotes[note.Lane].push_back(i);
+				difficulty.LaneStarts[note.Lane].push_back(note.Start);
+			}
 
-			if (aMaximumRange.has_value() && noteRange.End > aMaximumRange.value())
-				continue;
+			difficulty.MaxEnds.push_back(difficulty.MaxEnds.empty() ? note.End : Atrium::Math::Max(difficulty.MaxEnds.back(), note.End));
 
-			aCallback(noteRange);
+			if (difficulty.Chords.empty() || difficulty.Chords.back().Start != note.Start)
+			{
+				ChartChord& chord = difficulty.Chords.emplace_back();
+				chord.Start = note.Start;
+				chord.SustainEnd = note.End;
+				chord.FirstNote = i;
+				chord.Type = note.Type;
+			}
+
+			ChartChord& chord = difficulty.Chords.back();
+			chord.SustainEnd = Atrium::Math::Max(chord.SustainEnd, note.End);
+			chord.Lanes |= static_cast<std::uint8_t>(1u << note.Lane);
+			++chord.NoteCount;
 		}
 	}
 }
+
+std::size_t ChartGuitarTrack::FindLaneNote(const DifficultyNotes& aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const
+{
+	const std::vector<std::chrono::microseconds>& laneStarts = aDifficulty.LaneStarts[aLane];
+	return static_cast<std::size_t>(std::lower_bound(laneStarts.begin(), laneStarts.end(), aTimepoint) - laneStarts.begin());
+}
@@ -1,7 +1,9 @@
 // Filter "Chart"
 #pragma once
 
+#include "ChartCache.hpp"
 #include "ChartCommonStructures.hpp"
+#include "TempoMap.hpp"
 
 #include <array>
 #include <bitset>
@@ -9,45 +11,96 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <set>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct ChartTrackLoadData
 {
 	using PerDifficultyFlag = std::bitset<ChartTrackDifficultyCount>;
-	void AddNote(std::chrono::microseconds aTime, std::uint8_t aNote, std::uint8_t aVelocity);
+	struct NoteRange
+	{
+		std::chrono::microseconds Start = std::chrono::microseconds(0);
+		std::chrono::microseconds End = std::chrono::microseconds(0);
+		// Kept for rules that are defined in ticks, so they don't depend on the rounded times.
+		std::uint32_t StartTick = 0;
+	};
+
+	static constexpr std::size_t MidiNoteCount = 128;
+
+	// All staged data is allocated from aResource, which usually is a ChartLoadArena.
+	explicit ChartTrackLoadData(std::pmr::memory_resource* aResource = std::pmr::get_default_resource());
+
+	void AddNote(std::uint32_t aTick, std::chrono::microseconds aTime, std::uint8_t aNote, std::uint8_t aVelocity);
+	// Pairs up a whole track of note events at once, given as parallel arrays in event order.
+	void AddNotes(std::span<const std::uint32_t> someTicks, std::span<const std::chrono::microseconds> someTimes, std::span<const std::uint8_t> someNotes, std::span<const std::uint8_t> someVelocities);
 	void AddSysEx(std::chrono::microseconds aTime, const std::span<const std::uint8_t>& someData);
-	void AddLyric(std::chrono::microseconds aTime, const std::string& aText);
+	void AddLyric(std::chrono::microseconds aTime, std::string_view aText);
+
+	std::pmr::memory_resource* GetResource() const { return NoteRanges.get_allocator().resource(); }
 
-	std::map<std::uint8_t, std::chrono::microseconds> myPartialNotes;
+	// Start times and ticks of the notes that are currently on, indexed by MIDI note number.
+	std::array<std::chrono::microseconds, MidiNoteCount> myPartialNoteStarts = { };
+	std::array<std::uint32_t, MidiNoteCount> myPartialNoteStartTicks = { };
+	std::bitset<MidiNoteCount> myPartialNotes;
 
-	std::vector<std::pair<std::uint8_t, std::pair<std::chrono::microseconds, std::chrono::microseconds>>> NoteRanges;
-	std::vector<std::pair<std::chrono::microseconds, std::vector<std::uint8_t>>> SysExEvents;
-	std::map<std::chrono::microseconds, std::string> Lyrics;
+	// Per MIDI note number, its paired ranges in the order they ended.
+	std::pmr::vector<std::pmr::vector<NoteRange>> NoteRanges;
+	std::pmr::vector<std::pair<std::chrono::microseconds, std::pmr::vector<std::uint8_t>>> SysExEvents;
+	// Sorted by time.
+	std::pmr::vector<std::pair<std::chrono::microseconds, std::pmr::string>> Lyrics;
 
 	bool EnhancedOpens = false;
+
+	// The song's tempo map, for rules that are defined in ticks. Charts without one use the MIDI defaults.
+	const TempoMap* Tempos = nullptr;
 };
 
 class ChartTrack
 {
 public:
+	static std::unique_ptr<ChartTrack> CreateTrack(ChartTrackType aType);
+
 	static std::unique_ptr<ChartTrack> CreateTrackByName(const std::string& aName);
 
+	// Gets the type of track an instrument name maps to, without the "PART " prefix.
+	static std::optional<ChartTrackType> GetTrackTypeByName(std::string_view aName);
+
 public:
 	virtual ~ChartTrack() = default;
 
-	virtual const std::map<ChartTrackDifficulty, std::vector<ChartNoteRange>>& GetNoteRanges() const = 0;
+	// All notes of the difficulty, sorted by start time.
+	virtual std::span<const ChartNoteRange> GetNotes(ChartTrackDifficulty aDifficulty) const = 0;
+
+	// Indices into GetNotes of the notes in a lane, in start order.
+	virtual std::span<const std::uint32_t> GetLaneNotes(ChartTrackDifficulty aDifficulty, std::uint8_t aLane) const = 0;
+
+	// All chords of the difficulty, in start order. Single notes are chords with one lane.
+	virtual std::span<const ChartChord> GetChords(ChartTrackDifficulty aDifficulty) const = 0;
 
 	virtual const ChartNoteRange* GetClosestNote(ChartTrackDifficulty aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const = 0;
 
+	// The first chord starting at or after aTimepoint.
+	virtual const ChartChord* GetNextChord(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aTimepoint) const = 0;
+
 	virtual const ChartNoteRange* GetNextNote(ChartTrackDifficulty aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const = 0;
 
 	virtual std::vector<ChartNoteRange> GetNotesInRange(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aStart, std::chrono::microseconds anEnd) const = 0;
 
+	// A view of the notes overlapping the range, in start order, without copying them.
+	// The view has to be contiguous, so it can also hold notes that end before aStart when a longer note started before them.
+	virtual std::span<const ChartNoteRange> GetNoteSpanInRange(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aStart, std::chrono::microseconds anEnd) const = 0;
+
 	virtual bool Load(const ChartTrackLoadData& someData) = 0;
 
+	virtual void LoadCache(ChartCache::Reader& aReader) = 0;
+
+	virtual void SaveCache(ChartCache::Writer& aWriter) const = 0;
+
 	ChartTrackType GetType() const { return myType; }
 
 private:
@@ -57,6 +110,8 @@ private:
 class ChartGuitarTrack : public ChartTrack
 {
 public:
+	static constexpr std::uint8_t LaneCount = 5;
+
 	enum class Marker
 	{
 		Solo,
@@ -84,23 +139,76 @@ public:
 	};
 
 public:
-	const std::map<ChartTrackDifficulty, std::vector<ChartNoteRange>>& GetNoteRanges() const override { return myNoteRanges; }
+	std::span<const ChartNoteRange> GetNotes(ChartTrackDifficulty aDifficulty) const override { return myDifficulties[static_cast<std::size_t>(aDifficulty)].Notes; }
+
+	std::span<const std::uint32_t> GetLaneNotes(ChartTrackDifficulty aDifficulty, std::uint8_t aLane) const override;
+
+	std::span<const ChartChord> GetChords(ChartTrackDifficulty aDifficulty) const override { return myDifficulties[static_cast<std::size_t>(aDifficulty)].Chords; }
 
 	const ChartNoteRange* GetClosestNote(ChartTrackDifficulty aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const override;
 
+	const ChartChord* GetNextChord(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aTimepoint) const override;
+
 	const ChartNoteRange* GetNextNote(ChartTrackDifficulty aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const override;
 
 	std::vector<ChartNoteRange> GetNotesInRange(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aStart, std::chrono::microseconds anEnd) const override;
 
+	std::span<const ChartNoteRange> GetNoteSpanInRange(ChartTrackDifficulty aDifficulty, std::chrono::microseconds aStart, std::chrono::microseconds anEnd) const override;
+
 	bool Load(const ChartTrackLoadData& someData) override;
 
+	void LoadCache(ChartCache::Reader& aReader) override;
+
+	void SaveCache(ChartCache::Writer& aWriter) const override;
+
 private:
-	bool Load_AddNotes(const ChartTrackLoadData& someData);
-	bool Load_UpdateDefaultNoteTypes();
-	bool Load_ProcessSysEx(const ChartTrackLoadData& someData);
-	bool Load_ProcessMarkers(const ChartTrackLoadData& someData);
-	void Load_ForEachNoteInRange(std::function<void(ChartNoteRange&)> aCallback, const ChartTrackLoadData::PerDifficultyFlag& someDifficulties, std::optional<std::chrono::microseconds> aMinimumRange = {}, std::optional<std::chrono::microseconds> aMaximumRange = {});
+	// A change to every note that lies fully within a time range.
+	// These are collected from markers and SysEx events, then applied to all notes in one sweep.
+	enum class NoteModifierType { ForceHOPO, ForceStrum, Open, Tap };
+
+	struct NoteModifier
+	{
+		NoteModifierType Type = NoteModifierType::ForceHOPO;
+		std::chrono::microseconds Start = std::chrono::microseconds(0);
+		std::chrono::microseconds End = std::chrono::microseconds(0);
+	};
+
+	// One list per difficulty, allocated alongside the rest of the load data.
+	using NoteModifiers = std::pmr::vector<std::pmr::vector<NoteModifier>>;
+
+	// One list per difficulty, with the start tick of each of its notes in the same order as the notes.
+	using NoteStartTicks = std::pmr::vector<std::pmr::vector<std::uint32_t>>;
+
+	bool Load_AddNotes(const ChartTrackLoadData& someData, NoteStartTicks& outStartTicks);
+	bool Load_UpdateDefaultNoteTypes(const ChartTrackLoadData& someData, const NoteStartTicks& someStartTicks);
+	bool Load_ProcessSysEx(const ChartTrackLoadData& someData, NoteModifiers& outModifiers);
+	bool Load_ProcessMarkers(const ChartTrackLoadData& someData, NoteModifiers& outModifiers);
+	bool Load_ApplyNoteModifiers(const NoteModifiers& someModifiers);
+
+	struct DifficultyNotes
+	{
+		// Sorted by start time.
+		std::vector<ChartNoteRange> Notes;
+		// The start time of each note, so range searches can binary search them without pulling whole notes through the cache.
+		std::vector<std::chrono::microseconds> Starts;
+
+		// Per lane, the indices of its notes and their start times, in start order.
+		// Notes in a lane come from a single MIDI note number, so they never overlap.
+		std::array<std::vector<std::uint32_t>, LaneCount> LaneNotes;
+		std::array<std::vector<std::chrono::microseconds>, LaneCount> LaneStarts;
+
+		// The latest end time of each note and all notes before it, for finding the first note that can overlap a range.
+		std::vector<std::chrono::microseconds> MaxEnds;
+
+		std::vector<ChartChord> Chords;
+	};
+
+	// Builds the lookup indices from the loaded notes, whether they came from MIDI or a compiled chart.
+	void BuildIndices();
+
+	// Position of the first note in the lane starting at or after aTimepoint, in the lane's note indices.
+	std::size_t FindLaneNote(const DifficultyNotes& aDifficulty, std::uint8_t aLane, std::chrono::microseconds aTimepoint) const;
 
-	std::map<ChartTrackDifficulty, std::vector<ChartNoteRange>> myNoteRanges;
+	std::array<DifficultyNotes, ChartTrackDifficultyCount> myDifficulties;
 	std::vector<MarkerRange> myMarkers;
 };
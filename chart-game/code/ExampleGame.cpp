@@ -37,6 +37,8 @@ void ExampleGame::HandleStart()
 
 	OnStart_SetupWindows();
 
+	myChartPlayer.GetCalibration().Load(ChartCalibration::GetDefaultPath());
+
 	myChartRenderer.SetupResources(myEngineInstance.GetGraphicsAPI(), myWindow1->GetDescriptor().ColorGraphicsFormat);
 }
 
@@ -72,6 +74,8 @@ void ExampleGame::HandleImGui()
 void ExampleGame::HandleExit()
 {
 	ZoneScoped;
+
+	myChartPlayer.GetCalibration().Save(ChartCalibration::GetDefaultPath());
 }
 
 void ExampleGame::OnStart_SetupWindows()
@@ -91,6 +95,5 @@ void ExampleGame::OnStart_SetupWindows()
 
 void ExampleGame::HandleInput(const Atrium::InputEvent& anInputEvent)
 {
-	for (const auto& controller : myChartPlayer.GetControllers())
-		controller->HandleInput(anInputEvent);
+	myChartPlayer.HandleInput(anInputEvent);
 }
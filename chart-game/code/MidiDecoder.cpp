@@ -2,48 +2,55 @@
 
 #include <Atrium_Diagnostics.hpp>
 
+#include <cstring>
 #include <fstream>
 
 using namespace Atrium;
 
+static void RequireBytes(const std::span<const std::uint8_t>& aData, std::size_t aByteCount)
+{
+	if (aData.size() < aByteCount)
+		throw std::runtime_error("Unexpected end of MIDI data.");
+}
+
 template <typename T>
-std::uint8_t ReadFixed(std::istream& aStream, T& anOut, unsigned int anOffset = 0)
+static std::uint8_t ReadFixed(std::span<const std::uint8_t>& aData, T& anOut, unsigned int anOffset = 0)
 {
-	aStream.read(reinterpret_cast<char*>(&anOut), sizeof(T) - anOffset);
-	if constexpr (sizeof(T) != 1)
-		std::reverse(reinterpret_cast<char*>(&anOut), reinterpret_cast<char*>(&anOut) + sizeof(T) - anOffset);
-	return sizeof(T);
+	const std::size_t byteCount = sizeof(T) - anOffset;
+	RequireBytes(aData, byteCount);
+
+	// MIDI data is big-endian.
+	std::uint64_t value = 0;
+	for (std::size_t i = 0; i < byteCount; ++i)
+		value = (value << 8) | aData[i];
+
+	anOut = static_cast<T>(value);
+	aData = aData.subspan(byteCount);
+	return static_cast<std::uint8_t>(byteCount);
 }
 
 [[nodiscard]]
-std::uint8_t ReadVariable(std::istream& aStream, std::uint32_t& anOut)
+static std::uint32_t ReadVariable(std::span<const std::uint8_t>& aData)
 {
-	anOut = 0;
+	std::uint32_t value = 0;
 	std::uint8_t readBytes = 0;
 
 	std::uint8_t c = 0;
-	readBytes += ReadFixed(aStream, c);
-	anOut |= c;
-
-	if ((anOut & 0x80) != 0)
+	do
 	{
-		anOut &= 0x7F;
-		do
-		{
-			readBytes += ReadFixed(aStream, c);
-			anOut = (anOut << 7) + (c & 0x7F);
-		} while ((c & 0x80) != 0);
-	}
+		readBytes += ReadFixed(aData, c);
+		value = (value << 7) + (c & 0x7F);
+	} while ((c & 0x80) != 0 && readBytes < 4);
 
-	return readBytes;
+	return value;
 }
 
-std::string ReadText(std::istream& aStream, std::uint32_t aLength)
+static std::span<const std::uint8_t> ReadBytes(std::span<const std::uint8_t>& aData, std::uint32_t aLength)
 {
-	std::unique_ptr<char> textData(new char[aLength + 1]);
-	aStream.read(textData.get(), aLength);
-	textData.get()[aLength] = '\0';
-	return textData.get();
+	RequireBytes(aData, aLength);
+	const std::span<const std::uint8_t> bytes = aData.first(aLength);
+	aData = aData.subspan(aLength);
+	return bytes;
 }
 
 void MidiDecoder::DecomposeNoteNumber(const std::uint8_t aNoteIndex, std::uint8_t& outOctave, std::uint8_t& outNote)
@@ -60,44 +67,112 @@ std::string MidiDecoder::NoteNumberToString(const std::uint8_t aNoteIndex)
 	return std::string(notes[note]) + " " + (octave == 0 ? "-" : std::to_string(octave - 1));
 }
 
-void MidiDecoder::ProcessFile(const std::filesystem::path& aPath, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote)
+std::vector<std::uint8_t> MidiDecoder::ReadFile(const std::filesystem::path& aPath)
 {
+	ZoneScoped;
+
 	std::ifstream fileStream;
-	fileStream.open(aPath, std::ios::in | std::ios::binary);
-	while (!fileStream.eof())
+	fileStream.open(aPath, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!fileStream.is_open())
+		throw std::runtime_error("Couldn't open MIDI file.");
+
+	const std::streamoff fileSize = fileStream.tellg();
+	if (fileSize < 0)
+		throw std::runtime_error("Couldn't read MIDI file.");
+
+	std::vector<std::uint8_t> fileData(static_cast<std::size_t>(fileSize));
+	fileStream.seekg(0, std::ios::beg);
+	fileStream.read(reinterpret_cast<char*>(fileData.data()), fileData.size());
+	if (static_cast<std::size_t>(fileStream.gcount()) != fileData.size())
+		throw std::runtime_error("Couldn't read all of the MIDI file.");
+
+	return fileData;
+}
+
+void MidiDecoder::ProcessFile(const std::filesystem::path& aPath, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote)
+{
+	const std::vector<std::uint8_t> fileData = ReadFile(aPath);
+	ProcessData(fileData, outFormatType, outTicksPerQuarterNote);
+}
+
+std::vector<MidiDecoder::Chunk> MidiDecoder::FindChunks(std::span<const std::uint8_t> someData)
+{
+	ZoneScoped;
+
+	std::vector<Chunk> chunks;
+
+	std::span<const std::uint8_t> cursor = someData;
+	while (cursor.size() >= 8)
 	{
-		char chunkMarker[5];
-		fileStream >> chunkMarker;
-		chunkMarker[4] = '\0';
-
-		if (std::strcmp(chunkMarker, "MThd") == 0)
-			ReadHeaderChunk(fileStream, outFormatType, outTicksPerQuarterNote);
-		else if (std::strcmp(chunkMarker, "MTrk") == 0)
-			ProcessTrackChunk(fileStream);
+		const std::span<const std::uint8_t> chunkMarker = ReadBytes(cursor, 4);
+
+		Chunk& chunk = chunks.emplace_back();
+		ReadFixed(cursor, chunk.Length);
+		chunk.Offset = static_cast<std::size_t>(cursor.data() - someData.data());
+
+		if (std::memcmp(chunkMarker.data(), "MThd", 4) == 0)
+			chunk.Type = ChunkType::Header;
+		else if (std::memcmp(chunkMarker.data(), "MTrk", 4) == 0)
+			chunk.Type = ChunkType::Track;
+
+		ReadBytes(cursor, chunk.Length);
 	}
 
-	fileStream.close();
+	return chunks;
 }
 
-void MidiDecoder::ReadHeaderChunk(std::istream& aStream, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote)
+std::optional<std::string_view> MidiDecoder::FindTrackName(std::span<const std::uint8_t> aChunk)
 {
-	std::uint32_t chunkSize = 0;
-	ReadFixed(aStream, chunkSize);
+	for (const Event& event : ReadTrackEvents(aChunk))
+	{
+		if (event.Tick != 0)
+			break;
+
+		if (event.Type == EventType::Meta && event.Meta == MetaType::TrackName)
+			return event.GetText();
+	}
+
+	return { };
+}
 
-	ReadFixed(aStream, outFormatType);
+void MidiDecoder::ProcessData(std::span<const std::uint8_t> someData, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote)
+{
+	ZoneScoped;
+
+	for (const Chunk& chunk : FindChunks(someData))
+	{
+		switch (chunk.Type)
+		{
+		case ChunkType::Header:
+			ProcessHeaderChunk(chunk.GetData(someData), outFormatType, outTicksPerQuarterNote);
+			break;
+		case ChunkType::Track:
+			ProcessTrackChunk(chunk.GetData(someData));
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void MidiDecoder::ProcessHeaderChunk(std::span<const std::uint8_t> aChunk, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote)
+{
+	ReadFixed(aChunk, outFormatType);
 
 	// We're reading in all the tracks, so throw out the metadata track count here.
 	std::uint16_t trackCount = 0;
-	ReadFixed(aStream, trackCount);
+	ReadFixed(aChunk, trackCount);
 
 	{
 		std::uint16_t packedTimeCode = 0;
-		ReadFixed(aStream, packedTimeCode);
+		ReadFixed(aChunk, packedTimeCode);
 
 		if ((packedTimeCode & 0x8000) == 0)
 		{
 			// Ticks per quarter note
 			outTicksPerQuarterNote = (packedTimeCode & 0x7FFF);
+			if (outTicksPerQuarterNote == 0)
+				throw std::runtime_error("MIDI file has no ticks per quarter note.");
 		}
 		else
 		{
@@ -108,40 +183,87 @@ void MidiDecoder::ReadHeaderChunk(std::istream& aStream, FormatType& outFormatTy
 		}
 	}
 
-	// We read 6 fixed bytes, skip any remaining ones in this chunk.
-	aStream.seekg(chunkSize - 0x06, std::ios::cur);
+	// Any remaining bytes in the chunk are skipped along with it.
 }
 
-void MidiDecoder::ProcessTrackChunk(std::istream& aStream)
+void MidiDecoder::ProcessTrackChunk(std::span<const std::uint8_t> aChunk)
 {
 	OnNewTrack.Invoke();
 
-	std::uint32_t chunkSize = 0;
-	ReadFixed(aStream, chunkSize);
+	for (const Event& event : ReadTrackEvents(aChunk))
+		DispatchEvent(event);
+}
+
+std::uint32_t MidiDecoder::Event::GetTempo() const
+{
+	std::span<const std::uint8_t> payload = Payload;
+	std::uint32_t tempo = 0;
+	ReadFixed(payload, tempo, 1);
+	return tempo;
+}
+
+void MidiDecoder::Event::GetTimeSignature(std::uint8_t& outNumerator, std::uint8_t& outDenominator, std::uint8_t& outClock, std::uint8_t& outBase) const
+{
+	std::span<const std::uint8_t> payload = Payload;
+	ReadFixed(payload, outNumerator);
+	ReadFixed(payload, outDenominator);
+	outDenominator = 1 << outDenominator;
+	ReadFixed(payload, outClock);
+	ReadFixed(payload, outBase);
+}
 
-	std::uint32_t readBytes = 0;
-	std::uint8_t runningStatus = 0;
-	std::uint32_t tickCount = 0;
-	while (readBytes < chunkSize)
-		readBytes += ProcessEvent(aStream, tickCount, runningStatus);
+MidiDecoder::NoteBatch::NoteBatch(std::pmr::memory_resource* aResource)
+	: Ticks(aResource)
+	, Notes(aResource)
+	, Velocities(aResource)
+{
+}
 
-	aStream.seekg(chunkSize - readBytes, std::ios::cur);
+void MidiDecoder::NoteBatch::Add(const Event& aNoteEvent)
+{
+	Ticks.push_back(aNoteEvent.Tick);
+	Notes.push_back(aNoteEvent.Data[0]);
+	Velocities.push_back(aNoteEvent.Data[1]);
+}
+
+void MidiDecoder::NoteBatch::ReserveForChunk(std::size_t aChunkLength)
+{
+	// The smallest note event is 3 bytes: a single byte time delta and two data bytes under running status.
+	const std::size_t maximumNotes = aChunkLength / 3;
+	Ticks.reserve(maximumNotes);
+	Notes.reserve(maximumNotes);
+	Velocities.reserve(maximumNotes);
+}
+
+MidiDecoder::EventIterator::EventIterator(std::span<const std::uint8_t> aChunk)
+	: myData(aChunk)
+	, myIsEnd(false)
+{
+	ReadNext();
+}
+
+MidiDecoder::EventIterator& MidiDecoder::EventIterator::operator++()
+{
+	ReadNext();
+	return *this;
 }
 
-std::uint32_t MidiDecoder::ProcessEvent(std::istream& aStream, std::uint32_t& aTickCount, std::uint8_t& aRunningEventStatus)
+MidiDecoder::EventIterator MidiDecoder::EventIterator::operator++(int)
 {
-	std::uint32_t readBytes = 0;
-	std::uint32_t deltaTicks = 0;
-	readBytes += ReadVariable(aStream, deltaTicks);
-	aTickCount += deltaTicks;
+	EventIterator previous = *this;
+	ReadNext();
+	return previous;
+}
 
-	if (aStream.peek() >= 0x80)
-		readBytes += ReadFixed(aStream, aRunningEventStatus);
+bool MidiDecoder::EventIterator::operator==(const EventIterator& anOther) const
+{
+	if (myIsEnd || anOther.myIsEnd)
+		return myIsEnd == anOther.myIsEnd;
 
-	return ProcessEventData(aStream, aTickCount, aRunningEventStatus) + readBytes;
+	return myData.data() == anOther.myData.data();
 }
 
-std::uint32_t MidiDecoder::ProcessEventData(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t anEventStatus)
+void MidiDecoder::EventIterator::ReadNext()
 {
 	constexpr std::uint8_t NoteOff = 0x80;
 	constexpr std::uint8_t NoteOn = 0x90;
@@ -155,282 +277,240 @@ std::uint32_t MidiDecoder::ProcessEventData(std::istream& aStream, std::uint32_t
 	constexpr std::uint8_t SysEx_NoEnd = 0xF7;
 	constexpr std::uint8_t Meta = 0xFF;
 
+	if (myData.empty())
+	{
+		myIsEnd = true;
+		return;
+	}
+
+	myEvent.Tick += ReadVariable(myData);
+
+	RequireBytes(myData, 1);
+	if (myData.front() >= 0x80)
+		ReadFixed(myData, myRunningStatus);
+
+	myEvent.Status = myRunningStatus;
+	myEvent.Payload = { };
+
 	std::uint8_t type = 0;
-	std::uint8_t channelIndex = 0;
-	if (anEventStatus < SysEx_Standard)
+	if (myRunningStatus < SysEx_Standard)
 	{
-		type = (anEventStatus & 0xF0);
-		channelIndex = anEventStatus & 0x0F;
+		type = (myRunningStatus & 0xF0);
+		myEvent.Channel = myRunningStatus & 0x0F;
 	}
 	else
 	{
-		type = anEventStatus;
-		channelIndex = 0xFF;
+		type = myRunningStatus;
+		myEvent.Channel = 0xFF;
 	}
 
 	switch (type)
 	{
 	case NoteOff:
 	case NoteOn:
-		return ReadNoteEvent(aStream, aTickCount, type == NoteOn, channelIndex);
+		myEvent.Type = EventType::Note;
+		ReadFixed(myData, myEvent.Data[0]);
+		ReadFixed(myData, myEvent.Data[1]);
+		if (type == NoteOff)
+			myEvent.Data[1] = 0;
+		return;
 	case PolyKeyPressure:
-		return ReadPolyphonicKeyPressureEvent(aStream, aTickCount, channelIndex);
+		myEvent.Type = EventType::NotePressure;
+		ReadFixed(myData, myEvent.Data[0]);
+		ReadFixed(myData, myEvent.Data[1]);
+		return;
 	case ControlChange:
-		return ReadControlChangeEvent(aStream, aTickCount, channelIndex);
+		myEvent.Type = EventType::ControlChange;
+		ReadFixed(myData, myEvent.Data[0]);
+		ReadFixed(myData, myEvent.Data[1]);
+		return;
 	case ProgramChange:
-		return ReadProgramChangeEvent(aStream, aTickCount, channelIndex);
+		myEvent.Type = EventType::ProgramChange;
+		ReadFixed(myData, myEvent.Data[0]);
+		myEvent.Data[1] = 0;
+		return;
 	case ChannelPressure:
-		return ReadChannelPressureEvent(aStream, aTickCount, channelIndex);
+		myEvent.Type = EventType::ChannelPressure;
+		ReadFixed(myData, myEvent.Data[0]);
+		myEvent.Data[1] = 0;
+		return;
 	case PitchBend:
-		return ReadPitchBendEvent(aStream, aTickCount, channelIndex);
+		myEvent.Type = EventType::PitchBend;
+		ReadFixed(myData, myEvent.Data[0]);
+		ReadFixed(myData, myEvent.Data[1]);
+		return;
 	case SysEx_Standard:
 	case SysEx_NoEnd:
-		return ReadSysExEvent(aStream, aTickCount, type == SysEx_Standard);
-	case Meta:
-		return ReadMetaEvent(aStream, aTickCount);
-	}
-
-	throw std::runtime_error("Invalid event type.");
-}
+	{
+		myEvent.Type = EventType::SysEx;
 
-std::uint32_t MidiDecoder::ReadNoteEvent(std::istream& aStream, std::uint32_t aTickCount, bool anIsOn, std::uint8_t aChannelIndex)
-{
-	std::uint8_t noteNum = 0;
-	ReadFixed(aStream, noteNum);
+		const std::uint32_t length = ReadVariable(myData);
+		myEvent.Payload = ReadBytes(myData, length);
 
-	std::uint8_t noteVelocity = 0;
-	ReadFixed(aStream, noteVelocity);
+		// Leave out the end marker.
+		if (type == SysEx_Standard && !myEvent.Payload.empty())
+			myEvent.Payload = myEvent.Payload.first(myEvent.Payload.size() - 1);
+		return;
+	}
+	case Meta:
+	{
+		myEvent.Type = EventType::Meta;
 
-	if (!anIsOn)
-		noteVelocity = 0;
+		std::uint8_t metaType = 0;
+		ReadFixed(myData, metaType);
+		myEvent.Meta = MetaType(metaType);
 
-	OnNote.Invoke(aTickCount, aChannelIndex, noteNum, noteVelocity);
+		const std::uint32_t length = ReadVariable(myData);
+		myEvent.Payload = ReadBytes(myData, length);
+		return;
+	}
+	}
 
-	return 2;
+	throw std::runtime_error("Invalid event type.");
 }
 
-std::uint32_t MidiDecoder::ReadPolyphonicKeyPressureEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex)
+void MidiDecoder::DispatchEvent(const Event& anEvent)
 {
-	std::uint8_t noteNum = 0;
-	ReadFixed(aStream, noteNum);
-
-	std::uint8_t notePressure = 0;
-	ReadFixed(aStream, notePressure);
-
-	OnNotePressure.Invoke(aTickCount, aChannelIndex, noteNum, notePressure);
-
-	return 2;
+	switch (anEvent.Type)
+	{
+	case EventType::Note:
+		OnNote.Invoke(anEvent.Tick, anEvent.Channel, anEvent.Data[0], anEvent.Data[1]);
+		break;
+	case EventType::NotePressure:
+		OnNotePressure.Invoke(anEvent.Tick, anEvent.Channel, anEvent.Data[0], anEvent.Data[1]);
+		break;
+	case EventType::ControlChange:
+		DispatchControlChange(anEvent);
+		break;
+	case EventType::ProgramChange:
+		OnProgramChange.Invoke(anEvent.Tick, anEvent.Channel, anEvent.Data[0]);
+		break;
+	case EventType::ChannelPressure:
+		OnChannelPressure.Invoke(anEvent.Tick, anEvent.Channel, anEvent.Data[0]);
+		break;
+	case EventType::PitchBend:
+		Debug::LogWarning("Unfinished Event: %i Pitch bend - lsb: %i msb: %i", anEvent.Channel, anEvent.Data[0], anEvent.Data[1]);
+		break;
+	case EventType::SysEx:
+		OnSysEx.Invoke(anEvent.Tick, anEvent.Payload);
+		break;
+	case EventType::Meta:
+		DispatchMetaEvent(anEvent);
+		break;
+	}
 }
 
-std::uint32_t MidiDecoder::ReadControlChangeEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex)
+void MidiDecoder::DispatchControlChange(const Event& anEvent)
 {
-	std::uint8_t controllerNum = 0;
-	ReadFixed(aStream, controllerNum);
-
-	std::uint8_t controlValue = 0;
-	ReadFixed(aStream, controlValue);
+	const std::uint32_t tickCount = anEvent.Tick;
+	const std::uint8_t channelIndex = anEvent.Channel;
+	const std::uint8_t controllerNum = anEvent.Data[0];
+	const std::uint8_t controlValue = anEvent.Data[1];
 
 	switch (controllerNum)
 	{
 	case 120:
-		OnSoundOff.Invoke(aTickCount, aChannelIndex);
+		OnSoundOff.Invoke(tickCount, channelIndex);
 		break;
 	case 121:
-		OnResetAllControllers.Invoke(aTickCount, aChannelIndex, controlValue);
+		OnResetAllControllers.Invoke(tickCount, channelIndex, controlValue);
 		break;
 	case 122:
-		OnLocalControl.Invoke(aTickCount, aChannelIndex);
+		OnLocalControl.Invoke(tickCount, channelIndex);
 		break;
 	case 123:
-		OnAllNotesOff.Invoke(aTickCount, aChannelIndex);
+		OnAllNotesOff.Invoke(tickCount, channelIndex);
 		break;
 	case 124:
-		OnOmniOff.Invoke(aTickCount, aChannelIndex);
+		OnOmniOff.Invoke(tickCount, channelIndex);
 		break;
 	case 125:
-		OnOmniOn.Invoke(aTickCount, aChannelIndex);
+		OnOmniOn.Invoke(tickCount, channelIndex);
 		break;
 	case 126:
-		OnMonoOn.Invoke(aTickCount, aChannelIndex, controlValue);
+		OnMonoOn.Invoke(tickCount, channelIndex, controlValue);
 		break;
 	case 127:
-		OnPolyOn.Invoke(aTickCount, aChannelIndex);
+		OnPolyOn.Invoke(tickCount, channelIndex);
 		break;
 	default:
-		Debug::LogWarning("Unknown Event: %i Control change - N: %i V: %i", aChannelIndex, controllerNum, controlValue);
+		Debug::LogWarning("Unknown Event: %i Control change - N: %i V: %i", channelIndex, controllerNum, controlValue);
 		break;
 	}
-
-	return 2;
-}
-
-std::uint32_t MidiDecoder::ReadProgramChangeEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex)
-{
-	std::uint8_t programNum = 0;
-	ReadFixed(aStream, programNum);
-	OnProgramChange.Invoke(aTickCount, aChannelIndex, programNum);
-	return 1;
 }
 
-std::uint32_t MidiDecoder::ReadChannelPressureEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex)
+void MidiDecoder::DispatchMetaEvent(const Event& anEvent)
 {
-	std::uint8_t pressure = 0;
-	ReadFixed(aStream, pressure);
-	OnChannelPressure.Invoke(aTickCount, aChannelIndex, pressure);
-	return 1;
-}
-
-std::uint32_t MidiDecoder::ReadPitchBendEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex)
-{
-	std::uint8_t noteNum = 0;
-	ReadFixed(aStream, noteNum);
-
-	std::uint8_t leastSignificant = 0;
-	std::uint8_t mostSignificant = 0;
-	ReadFixed(aStream, leastSignificant);
-	ReadFixed(aStream, mostSignificant);
-
-	aTickCount;
-
-	Debug::LogWarning("Unfinished Event: %i Pitch bend - lsb: %i msb: %i", aChannelIndex, leastSignificant, mostSignificant);
-
-	return 3;
-}
-
-std::uint32_t MidiDecoder::ReadSysExEvent(std::istream& aStream, std::uint32_t aTickCount, bool aHasEnd)
-{
-	std::uint32_t readBytes = 0;
-
-	std::uint32_t length = 0;
-	readBytes += ReadVariable(aStream, length);
-
-	std::unique_ptr<std::uint8_t> data(new std::uint8_t[length]);
-	aStream.read(reinterpret_cast<char*>(data.get()), length);
-
-	OnSysEx.Invoke(aTickCount, std::span<const std::uint8_t>(data.get(), aHasEnd ? length - 1 : length));
-
-	return readBytes + length;
-}
-
-std::uint32_t MidiDecoder::ReadMetaEvent(std::istream& aStream, std::uint32_t aTickCount)
-{
-	std::uint32_t readBytes = 0;
-
-	unsigned char type = 0;
-	readBytes += ReadFixed(aStream, type);
-
-	std::uint32_t length = 0;
-	readBytes += ReadVariable(aStream, length);
-	readBytes += length;
+	const std::uint32_t tickCount = anEvent.Tick;
+	std::span<const std::uint8_t> payload = anEvent.Payload;
 
-	// We have the length so we add it onto the read bytes, just read the data in the switch.
-	switch (type)
+	switch (anEvent.Meta)
 	{
-	case 0x00:
+	case MetaType::SequenceNumber:
 	{
 		std::uint16_t sequenceNumber = 0;
-		ReadFixed(aStream, sequenceNumber);
-		OnSequenceNumber.Invoke(aTickCount, sequenceNumber);
-		return readBytes;
-	}
-	case 0x01:
-	{
-		std::string textData = ReadText(aStream, length);
-		OnText.Invoke(aTickCount, textData);
-		return readBytes;
-	}
-	case 0x02:
-	{
-		std::string textData = ReadText(aStream, length);
-		OnCopyrightNotice.Invoke(aTickCount, textData);
-		return readBytes;
-	}
-	case 0x03:
-	{
-		std::string textData = ReadText(aStream, length);
-		OnTrackName.Invoke(aTickCount, textData);
-		return readBytes;
-	}
-	case 0x04:
-	{
-		std::string textData = ReadText(aStream, length);
-		OnInstrumentName.Invoke(aTickCount, textData);
-		return readBytes;
-	}
-	case 0x05:
-	{
-		std::string textData = ReadText(aStream, length);
-		OnLyric.Invoke(aTickCount, textData);
-		return readBytes;
-	}
-	case 0x06:
-	{
-		std::string textData = ReadText(aStream, length);
-		OnMarker.Invoke(aTickCount, textData);
-		return readBytes;
-	}
-	case 0x07:
-	{
-		std::string textData = ReadText(aStream, length);
-		OnCuePoint.Invoke(aTickCount, textData);
-		return readBytes;
+		ReadFixed(payload, sequenceNumber);
+		OnSequenceNumber.Invoke(tickCount, sequenceNumber);
+		break;
 	}
-	case 0x20:
+	case MetaType::Text:
+		OnText.Invoke(tickCount, anEvent.GetText());
+		break;
+	case MetaType::CopyrightNotice:
+		OnCopyrightNotice.Invoke(tickCount, anEvent.GetText());
+		break;
+	case MetaType::TrackName:
+		OnTrackName.Invoke(tickCount, anEvent.GetText());
+		break;
+	case MetaType::InstrumentName:
+		OnInstrumentName.Invoke(tickCount, anEvent.GetText());
+		break;
+	case MetaType::Lyric:
+		OnLyric.Invoke(tickCount, anEvent.GetText());
+		break;
+	case MetaType::Marker:
+		OnMarker.Invoke(tickCount, anEvent.GetText());
+		break;
+	case MetaType::CuePoint:
+		OnCuePoint.Invoke(tickCount, anEvent.GetText());
+		break;
+	case MetaType::ChannelPrefix:
 	{
 		std::uint8_t channelPrefix = 0;
-		ReadFixed(aStream, channelPrefix);
+		ReadFixed(payload, channelPrefix);
 		Debug::LogWarning("Unknown Event: Meta - MIDI channel prefix: %i", channelPrefix);
-		return readBytes;
-	}
-	case 0x2F:
-	{
-		OnTrackEnd.Invoke(aTickCount);
-		return readBytes;
-	}
-	case 0x51:
-	{
-		std::uint32_t tempo = 0;
-		ReadFixed(aStream, tempo, 1);
-		OnSetTempo.Invoke(aTickCount, tempo);
-		return readBytes;
+		break;
 	}
-	case 0x54:
-	{
+	case MetaType::EndOfTrack:
+		OnTrackEnd.Invoke(tickCount);
+		break;
+	case MetaType::SetTempo:
+		OnSetTempo.Invoke(tickCount, anEvent.GetTempo());
+		break;
+	case MetaType::SMPTEOffset:
 		Debug::Log("Event: Meta - SMPTE offset");
 		break;
-	}
-	case 0x58:
+	case MetaType::TimeSignature:
 	{
 		std::uint8_t num = 0;
 		std::uint8_t den = 0;
 		std::uint8_t clk = 0;
 		std::uint8_t base = 0;
-		ReadFixed(aStream, num);
-		ReadFixed(aStream, den);
-		den = 1 << den;
-		ReadFixed(aStream, clk);
-		ReadFixed(aStream, base);
-		OnTimeSignature.Invoke(aTickCount, num, den, clk, base);
-		return readBytes;
+		anEvent.GetTimeSignature(num, den, clk, base);
+		OnTimeSignature.Invoke(tickCount, num, den, clk, base);
+		break;
 	}
-	case 0x59:
+	case MetaType::KeySignature:
 	{
 		std::uint8_t shpFlt = 0;
 		std::uint8_t majMin = 0;
-		ReadFixed(aStream, shpFlt);
-		ReadFixed(aStream, majMin);
-		OnKeySignature.Invoke(aTickCount, shpFlt, majMin);
-		return readBytes;
+		ReadFixed(payload, shpFlt);
+		ReadFixed(payload, majMin);
+		OnKeySignature.Invoke(tickCount, shpFlt, majMin);
+		break;
 	}
-	case 0x7F:
-	{
+	case MetaType::VendorDefined:
 		Debug::Log("Event: Meta - Vendor-defined");
 		break;
 	}
-	}
-
-	// Event data not processed, skip over.
-	aStream.seekg(length, std::ios::cur);
-
-	return readBytes;
 }
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <array>
 #include <chrono>
+#include <iterator>
 #include <filesystem>
+#include <memory_resource>
+#include <optional>
 #include <span>
+#include <string_view>
 #include <vector>
 
 #include <rose-common/EventSlot.hpp>
@@ -17,12 +22,158 @@ public:
 		Sequential = 2
 	};
 
+	enum class ChunkType
+	{
+		Header,
+		Track,
+		Unknown
+	};
+
+	struct Chunk
+	{
+		ChunkType Type = ChunkType::Unknown;
+		// Location of the chunk data in the file, excluding the 8 byte chunk marker and length.
+		std::size_t Offset = 0;
+		std::uint32_t Length = 0;
+
+		std::span<const std::uint8_t> GetData(std::span<const std::uint8_t> someFileData) const { return someFileData.subspan(Offset, Length); }
+	};
+
+	enum class EventType : std::uint8_t
+	{
+		Note,
+		NotePressure,
+		ControlChange,
+		ProgramChange,
+		ChannelPressure,
+		PitchBend,
+		SysEx,
+		Meta
+	};
+
+	enum class MetaType : std::uint8_t
+	{
+		SequenceNumber = 0x00,
+		Text = 0x01,
+		CopyrightNotice = 0x02,
+		TrackName = 0x03,
+		InstrumentName = 0x04,
+		Lyric = 0x05,
+		Marker = 0x06,
+		CuePoint = 0x07,
+		ChannelPrefix = 0x20,
+		EndOfTrack = 0x2F,
+		SetTempo = 0x51,
+		SMPTEOffset = 0x54,
+		TimeSignature = 0x58,
+		KeySignature = 0x59,
+		VendorDefined = 0x7F
+	};
+
+	// A single decoded track event.
+	// Channel events keep their data bytes in Data; notes have Data[0] as the note and Data[1] as the velocity, which is 0 for note offs.
+	// SysEx and meta events point their Payload into the chunk data instead of copying it.
+	struct Event
+	{
+		std::uint32_t Tick = 0;
+		EventType Type = EventType::Meta;
+		std::uint8_t Status = 0;
+		std::uint8_t Channel = 0xFF;
+		MetaType Meta = MetaType::SequenceNumber;
+		std::array<std::uint8_t, 2> Data = { 0, 0 };
+		std::span<const std::uint8_t> Payload;
+
+		std::string_view GetText() const { return std::string_view(reinterpret_cast<const char*>(Payload.data()), Payload.size()); }
+		std::uint32_t GetTempo() const;
+		void GetTimeSignature(std::uint8_t& outNumerator, std::uint8_t& outDenominator, std::uint8_t& outClock, std::uint8_t& outBase) const;
+	};
+
+	// Forward iterator decoding one event at a time from a track chunk.
+	class EventIterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Event;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Event*;
+		using reference = const Event&;
+
+		EventIterator() = default;
+		explicit EventIterator(std::span<const std::uint8_t> aChunk);
+
+		reference operator*() const { return myEvent; }
+		pointer operator->() const { return &myEvent; }
+
+		EventIterator& operator++();
+		EventIterator operator++(int);
+
+		bool operator==(const EventIterator& anOther) const;
+
+	private:
+		void ReadNext();
+
+		std::span<const std::uint8_t> myData;
+		Event myEvent;
+		std::uint8_t myRunningStatus = 0;
+		bool myIsEnd = true;
+	};
+
+	// Note events of a track as parallel arrays, for passes that work on all notes at once.
+	struct NoteBatch
+	{
+		explicit NoteBatch(std::pmr::memory_resource* aResource = std::pmr::get_default_resource());
+
+		std::pmr::vector<std::uint32_t> Ticks;
+		std::pmr::vector<std::uint8_t> Notes;
+		// 0 for note offs.
+		std::pmr::vector<std::uint8_t> Velocities;
+
+		void Add(const Event& aNoteEvent);
+		// Reserves enough room for every note event that could fit in a chunk of the given size.
+		void ReserveForChunk(std::size_t aChunkLength);
+		std::size_t Size() const { return Ticks.size(); }
+	};
+
+	class EventRange
+	{
+	public:
+		explicit EventRange(std::span<const std::uint8_t> aChunk) : myChunk(aChunk) { }
+
+		EventIterator begin() const { return EventIterator(myChunk); }
+		EventIterator end() const { return EventIterator(); }
+
+	private:
+		std::span<const std::uint8_t> myChunk;
+	};
+
 public:
 	static void DecomposeNoteNumber(const std::uint8_t aNoteIndex, std::uint8_t& outOctave, std::uint8_t& outNote);
 	static std::string NoteNumberToString(const std::uint8_t aNoteIndex);
 
+	static std::vector<std::uint8_t> ReadFile(const std::filesystem::path& aPath);
+
+	// Finds the location of every chunk in a MIDI file without decoding any of them.
+	static std::vector<Chunk> FindChunks(std::span<const std::uint8_t> someData);
+
+	// Looks for a track name meta event at the start of a track chunk, skipping over any other event data.
+	// Stops at the first event after tick 0, as that's where the track name is expected to be.
+	static std::optional<std::string_view> FindTrackName(std::span<const std::uint8_t> aChunk);
+
+	// Decodes the events of a track chunk on demand, without going through the event slots.
+	static EventRange ReadTrackEvents(std::span<const std::uint8_t> aChunk) { return EventRange(aChunk); }
+
+	// Reads the whole file into memory once and decodes it from there.
 	void ProcessFile(const std::filesystem::path& aPath, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote);
 
+	// Decodes a complete MIDI file already held in memory.
+	// Text and SysEx events are passed on as views into this data, so it needs to outlive the event handlers.
+	void ProcessData(std::span<const std::uint8_t> someData, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote);
+
+	// Decodes the data of a single chunk, as located by FindChunks.
+	// Track chunks don't depend on each other, so separate decoders may process them concurrently.
+	void ProcessHeaderChunk(std::span<const std::uint8_t> aChunk, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote);
+	void ProcessTrackChunk(std::span<const std::uint8_t> aChunk);
+
 public:
 	RoseCommon::EventSlot<> OnNewTrack;
 	RoseCommon::EventSlot<std::uint32_t> OnTrackEnd;
@@ -72,13 +223,13 @@ public:
 	RoseCommon::EventSlot<std::uint32_t, const std::span<const std::uint8_t>&> OnSysEx;
 
 	RoseCommon::EventSlot<std::uint32_t, std::uint16_t> OnSequenceNumber;
-	RoseCommon::EventSlot<std::uint32_t, const std::string&> OnText;
-	RoseCommon::EventSlot<std::uint32_t, const std::string&> OnCopyrightNotice;
-	RoseCommon::EventSlot<std::uint32_t, const std::string&> OnTrackName;
-	RoseCommon::EventSlot<std::uint32_t, const std::string&> OnInstrumentName;
-	RoseCommon::EventSlot<std::uint32_t, const std::string&> OnLyric;
-	RoseCommon::EventSlot<std::uint32_t, const std::string&> OnMarker;
-	RoseCommon::EventSlot<std::uint32_t, const std::string&> OnCuePoint;
+	RoseCommon::EventSlot<std::uint32_t, std::string_view> OnText;
+	RoseCommon::EventSlot<std::uint32_t, std::string_view> OnCopyrightNotice;
+	RoseCommon::EventSlot<std::uint32_t, std::string_view> OnTrackName;
+	RoseCommon::EventSlot<std::uint32_t, std::string_view> OnInstrumentName;
+	RoseCommon::EventSlot<std::uint32_t, std::string_view> OnLyric;
+	RoseCommon::EventSlot<std::uint32_t, std::string_view> OnMarker;
+	RoseCommon::EventSlot<std::uint32_t, std::string_view> OnCuePoint;
 
 	RoseCommon::EventSlot<std::uint32_t, std::uint32_t> OnSetTempo;
 	// Time delta, Numerator, Denominator, Metronome Clock, Number of notated 32nd notes per MIDI quarter note.
@@ -88,19 +239,7 @@ public:
 	RoseCommon::EventSlot<std::uint32_t, std::uint8_t, std::uint8_t> OnKeySignature;
 
 private:
-	void ReadHeaderChunk(std::istream& aStream, FormatType& outFormatType, std::uint16_t& outTicksPerQuarterNote);
-
-	void ProcessTrackChunk(std::istream& aStream);
-	
-	std::uint32_t ProcessEvent(std::istream& aStream, std::uint32_t& aTicksProgress, std::uint8_t& aRunningEventStatus);
-	std::uint32_t ProcessEventData(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t anEventStatus);
-
-	std::uint32_t ReadNoteEvent(std::istream& aStream, std::uint32_t aTickCount, bool anIsOn, std::uint8_t aChannelIndex);
-	std::uint32_t ReadPolyphonicKeyPressureEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex);
-	std::uint32_t ReadControlChangeEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex);
-	std::uint32_t ReadProgramChangeEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex);
-	std::uint32_t ReadChannelPressureEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex);
-	std::uint32_t ReadPitchBendEvent(std::istream& aStream, std::uint32_t aTickCount, std::uint8_t aChannelIndex);
-	std::uint32_t ReadSysExEvent(std::istream& aStream, std::uint32_t aTickCount, bool aHasEnd);
-	std::uint32_t ReadMetaEvent(std::istream& aStream, std::uint32_t aTickCount);
+	void DispatchEvent(const Event& anEvent);
+	void DispatchControlChange(const Event& anEvent);
+	void DispatchMetaEvent(const Event& anEvent);
 };
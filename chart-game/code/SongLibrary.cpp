@@ -0,0 +1,256 @@
+// Filter "Chart"
+#include "SongLibrary.hpp"
+
+#include "Atrium_Diagnostics.hpp"
+
+#include <algorithm>
+#include <string>
+#include <system_error>
+
+static std::string PathToBytes(const std::filesystem::path& aPath)
+{
+	const std::u8string utf8 = aPath.generic_u8string();
+	return std::string(reinterpret_cast<const char*>(utf8.data()), utf8.size());
+}
+
+static std::filesystem::path BytesToPath(const std::string& someBytes)
+{
+	return std::filesystem::path(std::u8string(reinterpret_cast<const char8_t*>(someBytes.data()), someBytes.size()));
+}
+
+std::filesystem::path SongLibrary::GetIndexPath(const std::filesystem::path& aDirectory)
+{
+	return aDirectory / "songs.index.bin";
+}
+
+SongLibrary::~SongLibrary()
+{
+	CancelScan();
+}
+
+void SongLibrary::Open(const std::filesystem::path& aDirectory)
+{
+	ZoneScoped;
+
+	CancelScan();
+
+	myDirectory = aDirectory;
+	mySongs.clear();
+
+	if (!LoadIndex())
+		mySongs.clear();
+}
+
+void SongLibrary::StartScan()
+{
+	ZoneScoped;
+
+	CancelScan();
+
+	// The workers can't look at the library while it's being updated, so they get their own copy of what's already known.
+	KnownSongs knownSongs;
+	for (const auto& [songIni, song] : mySongs)
+		knownSongs.emplace(songIni, std::make_pair(song.FileSize, song.LastWriteTime));
+
+	PendingScan& scan = myScan.emplace();
+	scan.State = std::make_shared<ScanState>();
+	scan.Result = std::async(std::launch::async, [directory = myDirectory, knownSongs = std::move(knownSongs), state = scan.State]()
+		{
+			ZoneScopedN("Song library scan");
+
+			WorkerPool::Group scan(WorkerPool::GetShared());
+			scan.Submit([&]() { ScanFolder(directory, knownSongs, *state, scan); });
+			scan.Wait();
+		}
+	);
+}
+
+void SongLibrary::CancelScan()
+{
+	if (!myScan)
+		return;
+
+	myScan->State->IsCancelled = true;
+	myScan->Result.wait();
+	UpdateScan();
+}
+
+bool SongLibrary::UpdateScan()
+{
+	if (!myScan)
+		return false;
+
+	ZoneScoped;
+
+	ScanState& state = *myScan->State;
+
+	{
+		std::scoped_lock lock(state.Mutex);
+		for (auto& [songIni, song] : state.FoundSongs)
+			mySongs.insert_or_assign(std::move(songIni), std::move(song));
+
+		myScan->IsChanged |= !state.FoundSongs.empty();
+		state.FoundSongs.clear();
+	}
+
+	if (myScan->Result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return false;
+
+	myScan->Result.get();
+
+	// Songs can only be known to be gone once every folder has been looked at.
+	const bool isCompleted = !state.IsCancelled;
+	bool isChanged = myScan->IsChanged;
+
+	if (isCompleted)
+	{
+		std::sort(state.SeenSongs.begin(), state.SeenSongs.end());
+		isChanged |= std::erase_if(mySongs, [&state](const auto& aSong) { return !std::binary_search(state.SeenSongs.begin(), state.SeenSongs.end(), aSong.first); }) > 0;
+	}
+
+	myScan.reset();
+	return isCompleted && isChanged;
+}
+
+bool SongLibrary::Rescan()
+{
+	ZoneScoped;
+
+	StartScan();
+	myScan->Result.wait();
+	return UpdateScan();
+}
+
+bool SongLibrary::SaveIndex() const
+{
+	ZoneScoped;
+
+	ChartCache::Writer writer(GetIndexHash());
+
+	writer.Write(static_cast<std::uint32_t>(mySongs.size()));
+	for (const auto& [songIni, song] : mySongs)
+	{
+		// Relative to the directory, to keep the index small.
+		writer.WriteString(PathToBytes(songIni.lexically_relative(myDirectory)));
+		writer.Write(song.FileSize);
+		writer.Write(song.LastWriteTime);
+		song.Info.SaveCache(writer);
+	}
+
+	const std::filesystem::path indexPath = GetIndexPath(myDirectory);
+	if (!writer.SaveToFile(indexPath))
+	{
+		Atrium::Debug::LogWarning("Couldn't write song library index to %s", indexPath.string().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+std::uint64_t SongLibrary::GetIndexHash() const
+{
+	const std::string directory = PathToBytes(myDirectory);
+	const std::uint64_t versionHash = ChartCache::Hash(std::span(reinterpret_cast<const std::uint8_t*>(&IndexVersion), sizeof(IndexVersion)));
+	return ChartCache::Hash(std::span(reinterpret_cast<const std::uint8_t*>(directory.data()), directory.size()), versionHash);
+}
+
+bool SongLibrary::LoadIndex()
+{
+	ZoneScoped;
+
+	const std::vector<std::uint8_t> indexData = ChartCache::ReadFile(GetIndexPath(myDirectory));
+	if (indexData.empty())
+		return false;
+
+	try
+	{
+		ChartCache::Reader reader(indexData);
+		if (!reader.ReadHeader(GetIndexHash()))
+			return false;
+
+		std::uint32_t count = 0;
+		reader.Read(count);
+
+		std::string relativePath;
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			reader.ReadString(relativePath);
+
+			Song& song = mySongs[myDirectory / BytesToPath(relativePath)];
+			reader.Read(song.FileSize);
+			reader.Read(song.LastWriteTime);
+			song.Info.LoadCache(reader);
+		}
+	}
+	catch (const std::exception& anException)
+	{
+		Atrium::Debug::LogWarning("Couldn't load song library index, rescanning everything: %s", anException.what());
+		return false;
+	}
+
+	return true;
+}
+
+void SongLibrary::ScanFolder(const std::filesystem::path& aFolder, const KnownSongs& someKnownSongs, ScanState& aState, WorkerPool::Group& aScan)
+{
+	ZoneScoped;
+
+	if (aState.IsCancelled)
+		return;
+
+	try
+	{
+		std::error_code error;
+		const std::filesystem::path canonicalFolder = std::filesystem::canonical(aFolder, error);
+		if (error)
+			return;
+
+		{
+			std::scoped_lock lock(aState.Mutex);
+			if (!aState.VisitedFolders.insert(canonicalFolder).second)
+				return;
+		}
+
+		const std::filesystem::path songIni = aFolder / "song.ini";
+
+		const std::uintmax_t fileSize = std::filesystem::file_size(songIni, error);
+		if (!error)
+		{
+			const std::int64_t lastWriteTime = std::filesystem::last_write_time(songIni, error).time_since_epoch().count();
+			if (error)
+				return;
+
+			++aState.SongCount;
+
+			const auto known = someKnownSongs.find(songIni);
+			const bool isUnchanged = known != someKnownSongs.end() && known->second == std::make_pair(fileSize, lastWriteTime);
+
+			Song song;
+			if (!isUnchanged)
+			{
+				song.Info.Load(songIni);
+				song.FileSize = fileSize;
+				song.LastWriteTime = lastWriteTime;
+			}
+
+			std::scoped_lock lock(aState.Mutex);
+			aState.SeenSongs.push_back(songIni);
+			if (!isUnchanged)
+				aState.FoundSongs.emplace_back(songIni, std::move(song));
+			return;
+		}
+
+		for (const auto& entry : std::filesystem::directory_iterator(aFolder))
+		{
+			if (aState.IsCancelled)
+				return;
+
+			if (entry.is_directory(error))
+				aScan.Submit([folder = entry.path(), &someKnownSongs, &aState, &aScan]() { ScanFolder(folder, someKnownSongs, aState, aScan); });
+		}
+	}
+	catch (const std::exception& anException)
+	{
+		Atrium::Debug::LogWarning("Couldn't scan %s: %s", aFolder.string().c_str(), anException.what());
+	}
+}
@@ -0,0 +1,110 @@
+// Filter "Chart"
+#pragma once
+
+#include "ChartData.hpp"
+#include "WorkerPool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+// The songs in a songs directory, with their song.ini already parsed.
+// The library is saved to an index file in the directory, so opening it again doesn't need a scan,
+// and rescans only parse the song.ini files that are new or changed since.
+// Any folder with a song.ini is a song, other folders are searched for more songs.
+class SongLibrary
+{
+public:
+	// Bump whenever the layout of the index file changes.
+	static constexpr std::uint32_t IndexVersion = 1;
+
+	struct Song
+	{
+		ChartInfo Info;
+
+		// Of the song.ini when it was parsed.
+		std::uintmax_t FileSize = 0;
+		std::int64_t LastWriteTime = 0;
+	};
+
+	static std::filesystem::path GetIndexPath(const std::filesystem::path& aDirectory);
+
+public:
+	~SongLibrary();
+
+	// Switches to aDirectory, with the songs from its index if it has a usable one.
+	void Open(const std::filesystem::path& aDirectory);
+
+	// Starts updating the library to match the directory, spread over a worker pool. A scan that's already running is cancelled first.
+	// New and changed songs are added as UpdateScan picks them up, and removed songs are dropped once the whole directory has been scanned.
+	void StartScan();
+
+	// Stops the scan, keeping the songs it found so far.
+	void CancelScan();
+
+	bool IsScanning() const { return myScan.has_value(); }
+
+	// Number of songs the current scan has come across so far, changed or not.
+	std::size_t GetScannedSongCount() const { return myScan ? myScan->State->SongCount.load() : 0; }
+
+	// Moves the songs found so far into the library. Call this regularly while scanning, from the thread that uses the library.
+	// Returns true when a scan completes and any song was added, removed or changed.
+	bool UpdateScan();
+
+	// Scans and waits for it to finish.
+	// Returns true if any song was added, removed or changed.
+	bool Rescan();
+
+	bool SaveIndex() const;
+
+	const std::filesystem::path& GetDirectory() const { return myDirectory; }
+
+	// Keyed by the path of each song's song.ini.
+	const std::map<std::filesystem::path, Song>& GetSongs() const { return mySongs; }
+
+private:
+	using KnownSongs = std::map<std::filesystem::path, std::pair<std::uintmax_t, std::int64_t>>;
+
+	// Shared between the library and the scan's worker threads.
+	struct ScanState
+	{
+		std::atomic<bool> IsCancelled = false;
+		std::atomic<std::size_t> SongCount = 0;
+
+		std::mutex Mutex;
+		// New and changed songs, waiting to be moved into the library.
+		std::vector<std::pair<std::filesystem::path, Song>> FoundSongs;
+		// Every song.ini that was found, to tell which songs have been removed.
+		std::vector<std::filesystem::path> SeenSongs;
+		// Canonical paths of the folders scanned so far, so links that loop back on themselves are only followed once.
+		std::set<std::filesystem::path> VisitedFolders;
+	};
+
+	struct PendingScan
+	{
+		std::shared_ptr<ScanState> State;
+		std::future<void> Result;
+		bool IsChanged = false;
+	};
+
+	// Scans a single folder, and queues a job in aScan for each folder inside it.
+	static void ScanFolder(const std::filesystem::path& aFolder, const KnownSongs& someKnownSongs, ScanState& aState, WorkerPool::Group& aScan);
+
+	// Ties the index to the directory it was made for, and to the current index layout.
+	std::uint64_t GetIndexHash() const;
+
+	bool LoadIndex();
+
+	std::filesystem::path myDirectory;
+	std::map<std::filesystem::path, Song> mySongs;
+
+	std::optional<PendingScan> myScan;
+};
@@ -0,0 +1,171 @@
+// Filter "Chart"
+#include "TempoMap.hpp"
+
+#include "Atrium_Diagnostics.hpp"
+
+#include <algorithm>
+
+std::chrono::microseconds TempoMap::Cursor::TickToTime(std::uint32_t aTick)
+{
+	const std::vector<Section>& sections = myTempoMap.GetSections();
+	if (sections.empty())
+		return myTempoMap.TickToTime(aTick);
+
+	if (mySection >= sections.size() || aTick < sections[mySection].TickStart)
+		mySection = myTempoMap.FindSectionByTick(aTick);
+
+	while ((mySection + 1) < sections.size() && sections[mySection + 1].TickStart <= aTick)
+		++mySection;
+
+	return myTempoMap.TickToTime(mySection, aTick);
+}
+
+std::uint32_t TempoMap::Cursor::TimeToTick(std::chrono::microseconds aTime)
+{
+	const std::vector<Section>& sections = myTempoMap.GetSections();
+	if (sections.empty())
+		return myTempoMap.TimeToTick(aTime);
+
+	if (mySection >= sections.size() || aTime < sections[mySection].TimeStart)
+		mySection = myTempoMap.FindSectionByTime(aTime);
+
+	while ((mySection + 1) < sections.size() && sections[mySection + 1].TimeStart <= aTime)
+		++mySection;
+
+	return myTempoMap.TimeToTick(mySection, aTime);
+}
+
+void TempoMap::Clear()
+{
+	mySections.clear();
+	myScaledTimeStarts.clear();
+}
+
+void TempoMap::SetTicksPerQuarterNote(std::uint16_t aTicksPerQuarterNote)
+{
+	Atrium::Debug::Assert(mySections.empty(), "Tick resolution has to be set before adding tempos.");
+	Atrium::Debug::Assert(aTicksPerQuarterNote > 0, "Tick resolution can't be zero.");
+	myTicksPerQuarterNote = aTicksPerQuarterNote;
+}
+
+bool TempoMap::AddTempo(std::uint32_t aTick, std::chrono::microseconds aTimePerBeat)
+{
+	// Conversions divide by the beat length.
+	if (aTimePerBeat.count() <= 0)
+		return false;
+
+	// MIDI plays at the default tempo until the first tempo change.
+	if (mySections.empty() && aTick != 0)
+		AddTempo(0, DefaultTimePerBeat);
+
+	if (!mySections.empty())
+	{
+		Atrium::Debug::Assert(mySections.back().TickStart <= aTick, "Tempo changes need to be added in order.");
+
+		// Several tempo changes on the same tick; the last one wins.
+		if (mySections.back().TickStart == aTick)
+		{
+			mySections.back().TimePerBeat = aTimePerBeat;
+			return true;
+		}
+	}
+
+	std::int64_t scaledTimeStart = 0;
+	if (!mySections.empty())
+	{
+		const Section& previous = mySections.back();
+		scaledTimeStart = myScaledTimeStarts.back() + static_cast<std::int64_t>(aTick - previous.TickStart) * previous.TimePerBeat.count();
+	}
+
+	Section& section = mySections.emplace_back();
+	section.TickStart = aTick;
+	section.TimeStart = std::chrono::microseconds(scaledTimeStart / myTicksPerQuarterNote);
+	section.TimePerBeat = aTimePerBeat;
+
+	myScaledTimeStarts.push_back(scaledTimeStart);
+	return true;
+}
+
+std::size_t TempoMap::FindSectionByTick(std::uint32_t aTick) const
+{
+	const auto next = std::upper_bound(
+		mySections.begin(), mySections.end(), aTick,
+		[](std::uint32_t aTick, const Section& aSection) { return aTick < aSection.TickStart; }
+	);
+
+	return next == mySections.begin() ? 0 : static_cast<std::size_t>(next - mySections.begin()) - 1;
+}
+
+std::size_t TempoMap::FindSectionByTime(std::chrono::microseconds aTime) const
+{
+	const auto next = std::upper_bound(
+		mySections.begin(), mySections.end(), aTime,
+		[](std::chrono::microseconds aTime, const Section& aSection) { return aTime < aSection.TimeStart; }
+	);
+
+	return next == mySections.begin() ? 0 : static_cast<std::size_t>(next - mySections.begin()) - 1;
+}
+
+std::chrono::microseconds TempoMap::TickToTime(std::uint32_t aTick) const
+{
+	if (mySections.empty())
+		return std::chrono::microseconds((static_cast<std::int64_t>(aTick) * DefaultTimePerBeat.count()) / myTicksPerQuarterNote);
+
+	return TickToTime(FindSectionByTick(aTick), aTick);
+}
+
+std::uint32_t TempoMap::TimeToTick(std::chrono::microseconds aTime) const
+{
+	if (aTime.count() < 0)
+		return 0;
+
+	if (mySections.empty())
+		return static_cast<std::uint32_t>(((aTime.count() + 1) * myTicksPerQuarterNote - 1) / DefaultTimePerBeat.count());
+
+	return TimeToTick(FindSectionByTime(aTime), aTime);
+}
+
+double TempoMap::GetBeatsAt(std::chrono::microseconds aTime) const
+{
+	if (mySections.empty() || aTime <= mySections.front().TimeStart)
+		return 0.0;
+
+	const std::size_t sectionIndex = FindSectionByTime(aTime);
+	const Section& section = mySections[sectionIndex];
+
+	const std::int64_t scaledTimeInSection = aTime.count() * myTicksPerQuarterNote - myScaledTimeStarts[sectionIndex];
+	const double ticks = static_cast<double>(section.TickStart) + static_cast<double>(scaledTimeInSection) / static_cast<double>(section.TimePerBeat.count());
+	return ticks / static_cast<double>(myTicksPerQuarterNote);
+}
+
+void TempoMap::TicksToTimes(std::span<const std::uint32_t> someTicks, std::span<std::chrono::microseconds> outTimes) const
+{
+	Atrium::Debug::Assert(someTicks.size() == outTimes.size(), "Need a time for every tick.");
+
+	Cursor cursor(*this);
+	for (std::size_t i = 0; i < someTicks.size(); ++i)
+		outTimes[i] = cursor.TickToTime(someTicks[i]);
+}
+
+std::chrono::microseconds TempoMap::TickToTime(std::size_t aSection, std::uint32_t aTick) const
+{
+	const Section& section = mySections[aSection];
+
+	if (aTick < section.TickStart)
+		return section.TimeStart;
+
+	const std::int64_t scaledTime = myScaledTimeStarts[aSection] + static_cast<std::int64_t>(aTick - section.TickStart) * section.TimePerBeat.count();
+	return std::chrono::microseconds(scaledTime / myTicksPerQuarterNote);
+}
+
+std::uint32_t TempoMap::TimeToTick(std::size_t aSection, std::chrono::microseconds aTime) const
+{
+	const Section& section = mySections[aSection];
+
+	if (aTime < section.TimeStart)
+		return section.TickStart;
+
+	// Last tick that still starts within the microsecond at aTime.
+	const std::int64_t scaledTimeEnd = (aTime.count() + 1) * myTicksPerQuarterNote - 1;
+	return section.TickStart + static_cast<std::uint32_t>((scaledTimeEnd - myScaledTimeStarts[aSection]) / section.TimePerBeat.count());
+}
@@ -0,0 +1,76 @@
+// Filter "Chart"
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Converts between MIDI ticks and time.
+// Times are derived from whole ticks at each conversion, so rounding never builds up across tempo changes.
+class TempoMap
+{
+public:
+	static constexpr std::chrono::microseconds DefaultTimePerBeat = std::chrono::microseconds(500'000);
+
+	struct Section
+	{
+		std::uint32_t TickStart = 0;
+		std::chrono::microseconds TimeStart = std::chrono::microseconds(0);
+		std::chrono::microseconds TimePerBeat = DefaultTimePerBeat;
+	};
+
+	// Remembers the last section used, for conversions that mostly move forward.
+	// Moving backward falls back to a binary search.
+	class Cursor
+	{
+	public:
+		Cursor(const TempoMap& aTempoMap) : myTempoMap(aTempoMap) { }
+
+		std::chrono::microseconds TickToTime(std::uint32_t aTick);
+		std::uint32_t TimeToTick(std::chrono::microseconds aTime);
+
+	private:
+		const TempoMap& myTempoMap;
+		std::size_t mySection = 0;
+	};
+
+public:
+	void Clear();
+
+	std::uint16_t GetTicksPerQuarterNote() const { return myTicksPerQuarterNote; }
+	void SetTicksPerQuarterNote(std::uint16_t aTicksPerQuarterNote);
+
+	// Tempo changes have to be added in tick order.
+	// Returns false without changing the map if the beat length isn't positive, as time would stop moving.
+	bool AddTempo(std::uint32_t aTick, std::chrono::microseconds aTimePerBeat);
+
+	const std::vector<Section>& GetSections() const { return mySections; }
+
+	// Index of the section containing the tick or time. The map has to have at least one section.
+	std::size_t FindSectionByTick(std::uint32_t aTick) const;
+	std::size_t FindSectionByTime(std::chrono::microseconds aTime) const;
+
+	std::chrono::microseconds TickToTime(std::uint32_t aTick) const;
+
+	// Gets the last tick at or before the time. The exact inverse of TickToTime.
+	std::uint32_t TimeToTick(std::chrono::microseconds aTime) const;
+
+	// Beats passed from tick 0 up to the time. Section tick starts double as the cumulative beat count, so this is a single lookup.
+	double GetBeatsAt(std::chrono::microseconds aTime) const;
+
+	// Converts a run of ticks in one pass, fastest when they're in increasing order.
+	void TicksToTimes(std::span<const std::uint32_t> someTicks, std::span<std::chrono::microseconds> outTimes) const;
+
+private:
+	std::chrono::microseconds TickToTime(std::size_t aSection, std::uint32_t aTick) const;
+	std::uint32_t TimeToTick(std::size_t aSection, std::chrono::microseconds aTime) const;
+
+	std::uint16_t myTicksPerQuarterNote = 480;
+
+	std::vector<Section> mySections;
+
+	// Section start times, in microseconds multiplied by ticks per quarter note.
+	// Kept separately so conversions can be done with exact integer math.
+	std::vector<std::int64_t> myScaledTimeStarts;
+};
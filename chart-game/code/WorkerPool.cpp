@@ -0,0 +1,130 @@
+#include "WorkerPool.hpp"
+
+#include "Atrium_Diagnostics.hpp"
+
+#include <algorithm>
+
+WorkerPool::Group::~Group()
+{
+	WaitForJobs();
+}
+
+void WorkerPool::Group::Submit(std::function<void()> aJob)
+{
+	{
+		std::scoped_lock lock(myMutex);
+		++myPendingJobs;
+	}
+
+	myPool.Submit([this, job = std::move(aJob)]()
+		{
+			try
+			{
+				job();
+			}
+			catch (...)
+			{
+				std::scoped_lock lock(myMutex);
+				if (!myFirstException)
+					myFirstException = std::current_exception();
+			}
+
+			// Notified under the lock, as the group may be destroyed as soon as a waiting thread sees the last job finish.
+			std::scoped_lock lock(myMutex);
+			if (--myPendingJobs == 0)
+				myJobsDone.notify_all();
+		}
+	);
+}
+
+void WorkerPool::Group::Wait()
+{
+	WaitForJobs();
+
+	std::exception_ptr exception;
+	{
+		std::scoped_lock lock(myMutex);
+		std::swap(exception, myFirstException);
+	}
+
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+void WorkerPool::Group::WaitForJobs()
+{
+	std::unique_lock lock(myMutex);
+	myJobsDone.wait(lock, [this]() { return myPendingJobs == 0; });
+}
+
+WorkerPool& WorkerPool::GetShared()
+{
+	static WorkerPool sharedPool;
+	return sharedPool;
+}
+
+WorkerPool::WorkerPool(std::size_t aThreadCount)
+{
+	aThreadCount = std::max<std::size_t>(aThreadCount, 1);
+
+	myThreads.reserve(aThreadCount);
+	for (std::size_t i = 0; i < aThreadCount; ++i)
+		myThreads.emplace_back([this]() { WorkerLoop(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::scoped_lock lock(myMutex);
+		myIsStopping = true;
+	}
+
+	myJobAvailable.notify_all();
+
+	for (std::thread& thread : myThreads)
+		thread.join();
+}
+
+void WorkerPool::Submit(std::function<void()> aJob)
+{
+	{
+		std::scoped_lock lock(myMutex);
+		myJobs.push_back(std::move(aJob));
+	}
+
+	myJobAvailable.notify_one();
+}
+
+void WorkerPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock lock(myMutex);
+			myJobAvailable.wait(lock, [this]() { return myIsStopping || !myJobs.empty(); });
+
+			// Queued jobs are still finished when stopping.
+			if (myJobs.empty())
+				return;
+
+			job = std::move(myJobs.front());
+			myJobs.pop_front();
+		}
+
+		// An exception leaving the thread would terminate the program.
+		try
+		{
+			job();
+		}
+		catch (const std::exception& anException)
+		{
+			Atrium::Debug::LogError("Worker job failed: %s", anException.what());
+		}
+		catch (...)
+		{
+			Atrium::Debug::LogError("Worker job failed with an unknown exception.");
+		}
+	}
+}
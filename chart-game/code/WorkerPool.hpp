@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+public:
+	// Jobs submitted together, so they can be waited on without also waiting for everything else on the pool.
+	// Waiting from one of the pool's own jobs could leave no thread to run the group, so only wait from outside the pool.
+	class Group
+	{
+	public:
+		explicit Group(WorkerPool& aPool) : myPool(aPool) { }
+		// Waits for any jobs still running, as they may refer to things owned by whoever made the group.
+		~Group();
+
+		Group(const Group&) = delete;
+		Group& operator=(const Group&) = delete;
+
+		// Jobs may be submitted from other jobs in the same group.
+		void Submit(std::function<void()> aJob);
+
+		// Blocks until every job in the group has finished.
+		// The first exception thrown by any of them is rethrown here.
+		void Wait();
+
+	private:
+		void WaitForJobs();
+
+		WorkerPool& myPool;
+
+		std::mutex myMutex;
+		std::condition_variable myJobsDone;
+		std::size_t myPendingJobs = 0;
+		std::exception_ptr myFirstException;
+	};
+
+	// Shared by everything that runs work in the background, so loads and scans don't each start threads of their own.
+	static WorkerPool& GetShared();
+
+public:
+	WorkerPool(std::size_t aThreadCount = std::thread::hardware_concurrency());
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	std::size_t GetThreadCount() const { return myThreads.size(); }
+
+	// Runs aFunction(i) for every i in [0, aCount) across the pool and waits for all of them.
+	// The first exception thrown by any of the calls is rethrown here once every call has finished.
+	template <typename Function>
+	void ForEach(std::size_t aCount, Function aFunction);
+
+	// Jobs submitted on their own have nowhere to report errors, so anything they throw is logged and dropped.
+	// Submit through a Group to get exceptions back.
+	void Submit(std::function<void()> aJob);
+
+private:
+	void WorkerLoop();
+
+	std::vector<std::thread> myThreads;
+
+	std::mutex myMutex;
+	std::condition_variable myJobAvailable;
+	std::deque<std::function<void()>> myJobs;
+	bool myIsStopping = false;
+};
+
+template <typename Function>
+inline void WorkerPool::ForEach(std::size_t aCount, Function aFunction)
+{
+	Group group(*this);
+	for (std::size_t i = 0; i < aCount; ++i)
+		group.Submit([&aFunction, i]() { aFunction(i); });
+
+	group.Wait();
+}
@@ -25,6 +25,34 @@ public class ChartGame_Executable : Atrium.ExecutableProject
     }
 }
 
+[Sharpmake.Generate]
+public class ChartGame_Benchmark : Atrium.ExecutableProject
+{
+    public ChartGame_Benchmark()
+    {
+        Name = "Chart game benchmark";
+        SourceRootPath = "[project.SharpmakeCsPath]/benchmark/";
+
+        // Builds the chart code along with the benchmarks, but not the game itself.
+        AdditionalSourceRootPaths.Add("[project.SharpmakeCsPath]/code/");
+        SourceFilesExcludeRegex.Add(@"[\\/]code[\\/](Program|ExampleGame)\.(cpp|hpp)$");
+    }
+
+    public override void ConfigureAll(Sharpmake.Project.Configuration conf, Sharpmake.Target target)
+    {
+        base.ConfigureAll(conf, target);
+
+        conf.SolutionFolder = "Executables";
+        conf.ProjectPath = "[project.SharpmakeCsPath]/benchmark/";
+        conf.IncludePaths.Add("[project.SharpmakeCsPath]/code/");
+
+        conf.Defines.Add("_CONSOLE");
+        conf.Options.Add(Sharpmake.Options.Vc.Linker.SubSystem.Console);
+
+        conf.AddPrivateDependency<Atrium.Engine>(target);
+    }
+}
+
 [Sharpmake.Generate]
 public class ChartGameSolution : Atrium.Solution
 {
@@ -39,6 +67,7 @@ public class ChartGameSolution : Atrium.Solution
         conf.SolutionPath = "[solution.SharpmakeCsPath]";
 
         conf.AddProject<ChartGame_Executable>(target);
+        conf.AddProject<ChartGame_Benchmark>(target);
     }
 }
 